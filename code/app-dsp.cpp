@@ -0,0 +1,3169 @@
+// SPDX-License-Identifier: zlib-acknowledgement
+
+INTERNAL u32
+u32_reverse_bits(u32 v, u32 num_bits)
+{
+  u32 result = 0;
+  for (u32 i = 0; i < num_bits; i += 1)
+  {
+    result = (result << 1) | (v & 1);
+    v >>= 1;
+  }
+  return result;
+}
+
+INTERNAL FFTPlan *
+fft_plan_create(MemArena *arena, u32 n)
+{
+  ASSERT(IS_POW2(n) && n >= 2);
+
+  FFTPlan *plan = MEM_ARENA_PUSH_STRUCT_ZERO(arena, FFTPlan);
+  plan->n = n;
+  plan->log2_n = u32_count_trailing_zeroes(n);
+
+  // NOTE(Ryan): Half the indices are fixed points or already visited, so over-allocate slightly
+  plan->bit_reverse = MEM_ARENA_PUSH_ARRAY(arena, u32, n);
+  plan->swaps = MEM_ARENA_PUSH_ARRAY(arena, u32, n);
+  for (u32 i = 0; i < n; i += 1)
+  {
+    u32 r = u32_reverse_bits(i, plan->log2_n);
+    plan->bit_reverse[i] = r;
+    if (i < r)
+    {
+      plan->swaps[plan->num_swaps++] = i;
+      plan->swaps[plan->num_swaps++] = r;
+    }
+  }
+
+  // IMPORTANT(Ryan): Evaluate in f64, as f32 error in the angle compounds over log2(n) stages
+  plan->twiddles_re = MEM_ARENA_PUSH_ARRAY(arena, f32, n - 1);
+  plan->twiddles_im = MEM_ARENA_PUSH_ARRAY(arena, f32, n - 1);
+  for (u32 half = 1; half < n; half <<= 1)
+  {
+    for (u32 k = 0; k < half; k += 1)
+    {
+      f64 angle = -F64_TAU * (f64)k / (f64)(2 * half);
+      plan->twiddles_re[half - 1 + k] = (f32)F64_COS(angle);
+      plan->twiddles_im[half - 1 + k] = (f32)F64_SIN(angle);
+    }
+  }
+
+  return plan;
+}
+
+INTERNAL b32
+fft_kernel_available(FFT_KERNEL kernel)
+{
+  switch (kernel)
+  {
+    default: return false;
+    case FFT_KERNEL_SCALAR: return true;
+    case FFT_KERNEL_SSE4: return LANE4_ENABLED;
+    case FFT_KERNEL_AVX2: return LANE8_ENABLED;
+  }
+}
+
+// NOTE(Ryan): The first two radix-2 stages only have twiddles of 1 and -i,
+// so are fused into a multiply-free radix-4 butterfly
+#define FFT_RADIX4_BUTTERFLY(r0, i0, r1, i1, r2, i2, r3, i3, out_re, out_im) do { \
+    f32 ar0 = (r0) + (r1), ai0 = (i0) + (i1); \
+    f32 ar1 = (r0) - (r1), ai1 = (i0) - (i1); \
+    f32 ar2 = (r2) + (r3), ai2 = (i2) + (i3); \
+    f32 ar3 = (r2) - (r3), ai3 = (i2) - (i3); \
+    /* NOTE(Ryan): -i * (ar3 + i*ai3) = ai3 - i*ar3 */ \
+    (out_re)[0] = ar0 + ar2; (out_im)[0] = ai0 + ai2; \
+    (out_re)[1] = ar1 + ai3; (out_im)[1] = ai1 - ar3; \
+    (out_re)[2] = ar0 - ar2; (out_im)[2] = ai0 - ai2; \
+    (out_re)[3] = ar1 - ai3; (out_im)[3] = ai1 + ar3; \
+  } while (0)
+
+// NOTE(Ryan): In-place bit reversal, then the radix-4 pass
+INTERNAL u32
+fft_permute_and_radix4(FFTPlan *plan, f32 *re, f32 *im)
+{
+  u32 n = plan->n;
+
+  for (u32 i = 0; i < plan->num_swaps; i += 2)
+  {
+    u32 a = plan->swaps[i], b = plan->swaps[i + 1];
+    SWAP(f32, re[a], re[b]);
+    SWAP(f32, im[a], im[b]);
+  }
+
+  if (n < 4) return 1;
+
+  for (u32 i = 0; i < n; i += 4)
+  {
+    FFT_RADIX4_BUTTERFLY(re[i], im[i], re[i + 1], im[i + 1], re[i + 2], im[i + 2], re[i + 3], im[i + 3], 
+                         re + i, im + i);
+  }
+
+  return 4;
+}
+
+// NOTE(Ryan): Out-of-place bit reversal fused with the radix-4 pass, saving a full pass over the data.
+// For j < n/4, bit reversed positions reverse(j) + {0, 1, 2, 3} hold inputs j, j + n/2, j + n/4, j + 3n/4
+INTERNAL void
+fft_gather_radix4(FFTPlan *plan, f32 *src_re, f32 *src_im, u32 src_stride, f32 *re, f32 *im)
+{
+  ASSERT(plan->n >= 4);
+
+  u32 q = plan->n / 4;
+  for (u32 j = 0; j < q; j += 1)
+  {
+    u32 i = plan->bit_reverse[j];
+    u32 s0 = j * src_stride, s1 = (j + 2 * q) * src_stride;
+    u32 s2 = (j + q) * src_stride, s3 = (j + 3 * q) * src_stride;
+    FFT_RADIX4_BUTTERFLY(src_re[s0], src_im[s0], src_re[s1], src_im[s1], 
+                         src_re[s2], src_im[s2], src_re[s3], src_im[s3], 
+                         re + i, im + i);
+  }
+}
+
+INTERNAL void
+fft_stage_scalar(FFTPlan *plan, f32 *re, f32 *im, u32 half)
+{
+  f32 *tw_re = plan->twiddles_re + (half - 1);
+  f32 *tw_im = plan->twiddles_im + (half - 1);
+  for (u32 start = 0; start < plan->n; start += 2 * half)
+  {
+    f32 *ar = re + start, *ai = im + start;
+    f32 *br = ar + half, *bi = ai + half;
+    for (u32 k = 0; k < half; k += 1)
+    {
+      f32 vr = br[k] * tw_re[k] - bi[k] * tw_im[k];
+      f32 vi = br[k] * tw_im[k] + bi[k] * tw_re[k];
+
+      f32 er = ar[k], ei = ai[k];
+      ar[k] = er + vr; ai[k] = ei + vi;
+      br[k] = er - vr; bi[k] = ei - vi;
+    }
+  }
+}
+
+#if LANE4_ENABLED
+INTERNAL void
+fft_stage_sse4(FFTPlan *plan, f32 *re, f32 *im, u32 half)
+{
+  f32 *tw_re = plan->twiddles_re + (half - 1);
+  f32 *tw_im = plan->twiddles_im + (half - 1);
+  for (u32 start = 0; start < plan->n; start += 2 * half)
+  {
+    f32 *ar = re + start, *ai = im + start;
+    f32 *br = ar + half, *bi = ai + half;
+    for (u32 k = 0; k < half; k += 4)
+    {
+      Lane4R32 wr = lane4_r32_load(tw_re + k), wi = lane4_r32_load(tw_im + k);
+      Lane4R32 xr = lane4_r32_load(br + k), xi = lane4_r32_load(bi + k);
+      Lane4R32 vr = lane_fmsub(xr, wr, xi * wi);
+      Lane4R32 vi = lane_fmadd(xr, wi, xi * wr);
+
+      Lane4R32 er = lane4_r32_load(ar + k), ei = lane4_r32_load(ai + k);
+      lane_store(ar + k, er + vr); lane_store(ai + k, ei + vi);
+      lane_store(br + k, er - vr); lane_store(bi + k, ei - vi);
+    }
+  }
+}
+#endif
+
+#if LANE8_ENABLED
+INTERNAL void
+fft_stage_avx2(FFTPlan *plan, f32 *re, f32 *im, u32 half)
+{
+  f32 *tw_re = plan->twiddles_re + (half - 1);
+  f32 *tw_im = plan->twiddles_im + (half - 1);
+  for (u32 start = 0; start < plan->n; start += 2 * half)
+  {
+    f32 *ar = re + start, *ai = im + start;
+    f32 *br = ar + half, *bi = ai + half;
+    for (u32 k = 0; k < half; k += 8)
+    {
+      Lane8R32 wr = lane8_r32_load(tw_re + k), wi = lane8_r32_load(tw_im + k);
+      Lane8R32 xr = lane8_r32_load(br + k), xi = lane8_r32_load(bi + k);
+      Lane8R32 vr = lane_fmsub(xr, wr, xi * wi);
+      Lane8R32 vi = lane_fmadd(xr, wi, xi * wr);
+
+      Lane8R32 er = lane8_r32_load(ar + k), ei = lane8_r32_load(ai + k);
+      lane_store(ar + k, er + vr); lane_store(ai + k, ei + vi);
+      lane_store(br + k, er - vr); lane_store(bi + k, ei - vi);
+    }
+  }
+}
+#endif
+
+// NOTE(Ryan): Stages shorter than the lane width fall back to a narrower kernel
+INTERNAL void
+fft_stages_kernel(FFTPlan *plan, f32 *re, f32 *im, u32 half, FFT_KERNEL kernel)
+{
+  ASSERT(fft_kernel_available(kernel));
+
+  for (; half < plan->n; half <<= 1)
+  {
+    switch (kernel)
+    {
+      default:
+      case FFT_KERNEL_SCALAR:
+      {
+        fft_stage_scalar(plan, re, im, half);
+      } break;
+#if LANE4_ENABLED
+      case FFT_KERNEL_SSE4:
+      {
+        if (half < 4) fft_stage_scalar(plan, re, im, half);
+        else fft_stage_sse4(plan, re, im, half);
+      } break;
+#endif
+#if LANE8_ENABLED
+      case FFT_KERNEL_AVX2:
+      {
+        if (half < 4) fft_stage_scalar(plan, re, im, half);
+        else if (half < 8) fft_stage_sse4(plan, re, im, half);
+        else fft_stage_avx2(plan, re, im, half);
+      } break;
+#endif
+    }
+  }
+}
+
+// NOTE(Ryan): Iterative in-place decimation-in-time cooley-tukey
+INTERNAL void
+fft_execute_kernel(FFTPlan *plan, f32 *re, f32 *im, FFT_KERNEL kernel)
+{
+  u32 half = fft_permute_and_radix4(plan, re, im);
+  fft_stages_kernel(plan, re, im, half, kernel);
+}
+
+INTERNAL void
+fft_execute(FFTPlan *plan, f32 *re, f32 *im)
+{
+  fft_execute_kernel(plan, re, im, FFT_KERNEL_NATIVE);
+}
+
+INTERNAL RFFTPlan *
+rfft_plan_create(MemArena *arena, u32 n)
+{
+  ASSERT(IS_POW2(n) && n >= 8);
+
+  RFFTPlan *plan = MEM_ARENA_PUSH_STRUCT_ZERO(arena, RFFTPlan);
+  plan->n = n;
+  plan->half = fft_plan_create(arena, n / 2);
+
+  plan->split_re = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 4 + 1);
+  plan->split_im = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 4 + 1);
+  for (u32 k = 0; k <= n / 4; k += 1)
+  {
+    f64 angle = -F64_TAU * (f64)k / (f64)n;
+    plan->split_re[k] = (f32)F64_COS(angle);
+    plan->split_im[k] = (f32)F64_SIN(angle);
+  }
+
+  return plan;
+}
+
+// NOTE(Ryan): out_re and out_im require n/2 + 1 entries
+INTERNAL void
+rfft_execute_kernel(RFFTPlan *plan, f32 *in, f32 *out_re, f32 *out_im, FFT_KERNEL kernel)
+{
+  u32 half_n = plan->n / 2;
+
+  // NOTE(Ryan): z[m] = x[2m] + i*x[2m + 1], read straight from the input in bit reversed order
+  fft_gather_radix4(plan->half, in, in + 1, 2, out_re, out_im);
+  fft_stages_kernel(plan->half, out_re, out_im, 4, kernel);
+
+  // NOTE(Ryan): Split Z into the spectra of the even and odd samples, then recombine with one radix-2 butterfly:
+  //   E[k] = (Z[k] + conj(Z[n/2 - k])) / 2
+  //   O[k] = -i * (Z[k] - conj(Z[n/2 - k])) / 2
+  //   X[k] = E[k] + W^k * O[k]
+  //   X[n/2 - k] = conj(E[k] - W^k * O[k])
+  f32 z0r = out_re[0], z0i = out_im[0];
+  out_re[0] = z0r + z0i; out_im[0] = 0.f;
+  out_re[half_n] = z0r - z0i; out_im[half_n] = 0.f;
+
+  for (u32 k = 1; k <= half_n / 2; k += 1)
+  {
+    u32 mk = half_n - k;
+    f32 ar = out_re[k], ai = out_im[k];
+    f32 br = out_re[mk], bi = -out_im[mk];
+
+    f32 even_r = 0.5f * (ar + br), even_i = 0.5f * (ai + bi);
+    f32 odd_r = 0.5f * (ai - bi), odd_i = -0.5f * (ar - br);
+
+    f32 wr = plan->split_re[k], wi = plan->split_im[k];
+    f32 vr = odd_r * wr - odd_i * wi;
+    f32 vi = odd_r * wi + odd_i * wr;
+
+    out_re[k] = even_r + vr; out_im[k] = even_i + vi;
+    if (mk != k)
+    {
+      out_re[mk] = even_r - vr; out_im[mk] = -(even_i - vi);
+    }
+  }
+}
+
+INTERNAL void
+rfft_execute(RFFTPlan *plan, f32 *in, f32 *out_re, f32 *out_im)
+{
+  rfft_execute_kernel(plan, in, out_re, out_im, FFT_KERNEL_NATIVE);
+}
+
+// NOTE(Ryan): Inverse of rfft_execute, with the 1/n. in_re and in_im are the n/2 + 1 bins, and are destroyed.
+// Undoes the split to get Z = E + i*O back, then z[m] = x[2m] + i*x[2m + 1] is the inverse half size transform of Z, 
+// run as a forward transform of its conjugate
+INTERNAL void
+rfft_inverse_execute(RFFTPlan *plan, f32 *in_re, f32 *in_im, f32 *out)
+{
+  u32 half_n = plan->n / 2;
+
+  f32 x0 = in_re[0], x_half = in_re[half_n];
+  in_re[0] = 0.5f * (x0 + x_half);
+  in_im[0] = -0.5f * (x0 - x_half);
+
+  for (u32 k = 1; k <= half_n / 2; k += 1)
+  {
+    u32 mk = half_n - k;
+    f32 ar = in_re[k], ai = in_im[k];
+    f32 br = in_re[mk], bi = in_im[mk];
+
+    // NOTE(Ryan): E = (X[k] + conj(X[n/2 - k])) / 2, O = (X[k] - conj(X[n/2 - k])) * conj(W^k) / 2
+    f32 even_r = 0.5f * (ar + br), even_i = 0.5f * (ai - bi);
+    f32 dr = 0.5f * (ar - br), di = 0.5f * (ai + bi);
+    f32 wr = plan->split_re[k], wi = plan->split_im[k];
+    f32 odd_r = dr * wr + di * wi;
+    f32 odd_i = di * wr - dr * wi;
+
+    // NOTE(Ryan): conj(Z[k]), and Z[n/2 - k] works out to conj(E) + i*conj(O)
+    in_re[k] = even_r - odd_i; in_im[k] = -(even_i + odd_r);
+    if (mk != k)
+    {
+      in_re[mk] = even_r + odd_i; in_im[mk] = even_i - odd_r;
+    }
+  }
+
+  fft_execute(plan->half, in_re, in_im);
+
+  f32 scale = 1.0f / half_n;
+  for (u32 m = 0; m < half_n; m += 1)
+  {
+    out[2 * m] = in_re[m] * scale;
+    out[2 * m + 1] = -in_im[m] * scale;
+  }
+}
+
+INTERNAL s16
+s16_saturate(s32 v)
+{
+#if PLATFORM_CORTEXM4
+  return (s16)__SSAT(v, 16);
+#else
+  return (s16)CLAMP(S16_MIN, v, S16_MAX);
+#endif
+}
+
+INTERNAL s16
+s16_q15_from_f64(f64 v)
+{
+  f64 scaled = v * 32768.0;
+  return s16_saturate((s32)(scaled + ((scaled < 0.0) ? -0.5 : 0.5)));
+}
+
+// NOTE(Ryan): Taylor series, so plan creation doesn't need libm either. 
+// 30 terms reach f64 precision for |x| <= pi
+INTERNAL void
+f64_sin_cos_series(f64 x, f64 *sin_out, f64 *cos_out)
+{
+  f64 s = 0.0, c = 0.0, term = 1.0;
+  for (u32 k = 0; k < 30; k += 1)
+  {
+    // NOTE(Ryan): term is x^k / k!, with signs repeating every 4
+    f64 signed_term = (k & 2) ? -term : term;
+    if (k & 1) s += signed_term;
+    else c += signed_term;
+    term *= x / (f64)(k + 1);
+  }
+  *sin_out = s;
+  *cos_out = c;
+}
+
+INTERNAL FFTPlanQ15 *
+fft_q15_plan_create(MemArena *arena, u32 n)
+{
+  ASSERT(IS_POW2(n) && n >= 2);
+
+  FFTPlanQ15 *plan = MEM_ARENA_PUSH_STRUCT_ZERO(arena, FFTPlanQ15);
+  plan->n = n;
+  plan->log2_n = u32_count_trailing_zeroes(n);
+
+  plan->swaps = MEM_ARENA_PUSH_ARRAY(arena, u32, n);
+  for (u32 i = 0; i < n; i += 1)
+  {
+    u32 r = u32_reverse_bits(i, plan->log2_n);
+    if (i < r)
+    {
+      plan->swaps[plan->num_swaps++] = i;
+      plan->swaps[plan->num_swaps++] = r;
+    }
+  }
+
+  // NOTE(Ryan): Angles stay in (-pi, 0], so cos never reaches -1 and sin only at -pi/2 where cos is 0.
+  // That bounds |b * w| to sqrt(2) of full scale, which the s32 products hold
+  plan->twiddles_re = MEM_ARENA_PUSH_ARRAY(arena, s16, n - 1);
+  plan->twiddles_im = MEM_ARENA_PUSH_ARRAY(arena, s16, n - 1);
+  for (u32 half = 1; half < n; half <<= 1)
+  {
+    for (u32 k = 0; k < half; k += 1)
+    {
+      f64 sine = 0.0, cosine = 0.0;
+      f64_sin_cos_series(-F64_TAU * (f64)k / (f64)(2 * half), &sine, &cosine);
+      plan->twiddles_re[half - 1 + k] = s16_q15_from_f64(cosine);
+      plan->twiddles_im[half - 1 + k] = s16_q15_from_f64(sine);
+    }
+  }
+
+  return plan;
+}
+
+// NOTE(Ryan): Halved sum and difference of a and t, rounded
+#define FFT_Q15_BUTTERFLY(a_re, a_im, b_re, b_im, t_re, t_im) do { \
+    s32 ar = (a_re), ai = (a_im), tr = (t_re), ti = (t_im); \
+    (a_re) = s16_saturate((ar + tr + 1) >> 1); \
+    (a_im) = s16_saturate((ai + ti + 1) >> 1); \
+    (b_re) = s16_saturate((ar - tr + 1) >> 1); \
+    (b_im) = s16_saturate((ai - ti + 1) >> 1); \
+  } while (0)
+
+// NOTE(Ryan): One run of half butterflies, between a and b = a + half
+INTERNAL void
+fft_q15_span(s16 *RESTRICT a_re, s16 *RESTRICT a_im, s16 *RESTRICT b_re, s16 *RESTRICT b_im, 
+             s16 *w_re, s16 *w_im, u32 half)
+{
+  // NOTE(Ryan): The first twiddle is 1, which Q15 can only get to within an LSB of, so skip the multiply
+  FFT_Q15_BUTTERFLY(a_re[0], a_im[0], b_re[0], b_im[0], b_re[0], b_im[0]);
+  for (u32 k = 1; k < half; k += 1)
+  {
+    // NOTE(Ryan): b * w rounded from Q30 back to Q15
+    s32 t_re = ((s32)b_re[k] * w_re[k] - (s32)b_im[k] * w_im[k] + (1 << 14)) >> 15;
+    s32 t_im = ((s32)b_re[k] * w_im[k] + (s32)b_im[k] * w_re[k] + (1 << 14)) >> 15;
+    FFT_Q15_BUTTERFLY(a_re[k], a_im[k], b_re[k], b_im[k], t_re, t_im);
+  }
+}
+
+// NOTE(Ryan): In place, returning the DFT / n
+INTERNAL void
+fft_q15_execute(FFTPlanQ15 *plan, s16 *re, s16 *im)
+{
+  u32 n = plan->n;
+
+  for (u32 i = 0; i < plan->num_swaps; i += 2)
+  {
+    u32 a = plan->swaps[i], b = plan->swaps[i + 1];
+    SWAP(s16, re[a], re[b]);
+    SWAP(s16, im[a], im[b]);
+  }
+
+  // NOTE(Ryan): The first two stages only have twiddles of 1 and -i, which are exact, so fuse them multiply-free. 
+  // The results are the same bits as running them separately
+  u32 first_half = 1;
+  if (n >= 4)
+  {
+    for (u32 i = 0; i < n; i += 4)
+    {
+      s16 *r = re + i, *m = im + i;
+      FFT_Q15_BUTTERFLY(r[0], m[0], r[1], m[1], r[1], m[1]);
+      FFT_Q15_BUTTERFLY(r[2], m[2], r[3], m[3], r[3], m[3]);
+      FFT_Q15_BUTTERFLY(r[0], m[0], r[2], m[2], r[2], m[2]);
+      // NOTE(Ryan): -i * (re + i*im) = im - i*re
+      FFT_Q15_BUTTERFLY(r[1], m[1], r[3], m[3], m[3], -(s32)r[3]);
+    }
+    first_half = 4;
+  }
+
+  for (u32 half = first_half; half < n; half <<= 1)
+  {
+    s16 *w_re = plan->twiddles_re + half - 1;
+    s16 *w_im = plan->twiddles_im + half - 1;
+    for (u32 start = 0; start < n; start += 2 * half)
+    {
+      fft_q15_span(re + start, im + start, re + start + half, im + start + half, w_re, w_im, half);
+    }
+  }
+}
+
+// NOTE(Ryan): log2(1 + i/32) in Q16
+GLOBAL u32 g_q16_log2_table[33] = {
+  0, 2909, 5732, 8473, 11136, 13727, 16248, 18704, 21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346, 
+  38336, 40286, 42196, 44068, 45904, 47705, 49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047, 
+  65536
+};
+
+// NOTE(Ryan): Exponent from the leading bit, then the top 5 bits of the mantissa index the table 
+// and the next 16 interpolate. Error is under 2e-4
+INTERNAL s32
+u32_log2_q16(u32 v)
+{
+  ASSERT(v != 0);
+  u32 msb = 31 - u32_count_leading_zeroes(v);
+  u32 fraction = (v << (31 - msb)) & 0x7fffffff;
+  u32 index = fraction >> 26;
+  u32 remainder = (fraction >> 10) & 0xffff;
+  u32 lo = g_q16_log2_table[index], hi = g_q16_log2_table[index + 1];
+  return (s32)((msb << 16) + lo + (((hi - lo) * remainder) >> 16));
+}
+
+// NOTE(Ryan): Q16 log2 of the power of the first count bins. Offset to undo the 1/n and the Q30 of the squares, 
+// so it's log2(re^2 + im^2) of the float FFT of the samples / 32768
+INTERNAL void
+fft_q15_log2_power(FFTPlanQ15 *plan, s16 *re, s16 *im, u32 count, s32 *log2_power)
+{
+  s32 offset = ((s32)(2 * plan->log2_n) - 30) * (1 << 16);
+  for (u32 i = 0; i < count; i += 1)
+  {
+    // NOTE(Ryan): Each square is at most 2^30, so the sum fits
+    u32 power = (u32)((s32)re[i] * re[i]) + (u32)((s32)im[i] * im[i]);
+    log2_power[i] = (power == 0) ? Q16_LOG2_POWER_FLOOR : u32_log2_q16(power) + offset;
+  }
+}
+
+INTERNAL String8
+window_name(WINDOW window)
+{
+  switch (window)
+  {
+    default: return str8_lit("Unknown");
+    case WINDOW_HANN: return str8_lit("Hann");
+    case WINDOW_HAMMING: return str8_lit("Hamming");
+    case WINDOW_BLACKMAN_HARRIS: return str8_lit("Blackman-Harris");
+    case WINDOW_FLAT_TOP: return str8_lit("Flat-top");
+  }
+}
+
+// NOTE(Ryan): All are cosine sums w[i] = a0 - a1*cos(x) + a2*cos(2x) - a3*cos(3x) + a4*cos(4x)
+// NOTE(Ryan): Indexed by WINDOW
+GLOBAL f64 g_window_cosine_terms[WINDOW_COUNT][5] = {
+  {0.5, 0.5},
+  {0.54, 0.46},
+  {0.35875, 0.48829, 0.14128, 0.01168},
+  {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368},
+};
+
+INTERNAL WindowTable *
+window_table_create(MemArena *arena, u32 n)
+{
+  WindowTable *table = MEM_ARENA_PUSH_STRUCT_ZERO(arena, WindowTable);
+  table->n = n;
+
+  for (u32 w = 0; w < WINDOW_COUNT; w += 1)
+  {
+    f32 *coefficients = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+    f64 sum = 0.0;
+    for (u32 i = 0; i < n; i += 1)
+    {
+      // NOTE(Ryan): Periodic rather than symmetric, i.e. divide by n not n - 1, 
+      // so the window lines up with the DFT basis
+      f64 x = F64_TAU * (f64)i / (f64)n;
+      f64 value = 0.0, sign = 1.0;
+      for (u32 k = 0; k < ARRAY_COUNT(g_window_cosine_terms[w]); k += 1)
+      {
+        value += sign * g_window_cosine_terms[w][k] * F64_COS(k * x);
+        sign = -sign;
+      }
+      coefficients[i] = (f32)value;
+      sum += value;
+    }
+    table->coefficients[w] = coefficients;
+    table->coherent_gain[w] = (f32)(sum / n);
+  }
+
+  return table;
+}
+
+// NOTE(Ryan): Differentiating the cosine sum, dw/di * n / tau = a1*sin(x) - 2*a2*sin(2x) + 3*a3*sin(3x) - ...
+INTERNAL void
+window_table_add_derivatives(MemArena *arena, WindowTable *table)
+{
+  u32 n = table->n;
+  for (u32 w = 0; w < WINDOW_COUNT; w += 1)
+  {
+    f32 *derivatives = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+    for (u32 i = 0; i < n; i += 1)
+    {
+      f64 x = F64_TAU * (f64)i / (f64)n;
+      f64 value = 0.0, sign = 1.0;
+      for (u32 k = 1; k < ARRAY_COUNT(g_window_cosine_terms[w]); k += 1)
+      {
+        value += sign * k * g_window_cosine_terms[w][k] * F64_SIN(k * x);
+        sign = -sign;
+      }
+      derivatives[i] = (f32)value;
+    }
+    table->derivatives[w] = derivatives;
+  }
+}
+
+// NOTE(Ryan): out[i] = ring[(start + i) % ring_count] * window[i] for i in [0, n).
+// Done as the two contiguous runs either side of the wrap
+INTERNAL void
+window_apply_ring(f32 *out, f32 *window, u32 n, f32 *ring, u32 ring_count, u32 start)
+{
+  ASSERT(start < ring_count && n <= ring_count);
+
+  u32 first_len = MIN(n, ring_count - start);
+  f32 *src[2] = {ring + start, ring};
+  f32 *dst[2] = {out, out + first_len};
+  f32 *win[2] = {window, window + first_len};
+  u32 len[2] = {first_len, n - first_len};
+
+  for (u32 run = 0; run < 2; run += 1)
+  {
+    u32 i = 0;
+    for (; i + LANE_WIDTH <= len[run]; i += LANE_WIDTH)
+    {
+      LaneR32 s = lane_r32_load(src[run] + i);
+      LaneR32 w = lane_r32_load(win[run] + i);
+      lane_store(dst[run] + i, s * w);
+    }
+    for (; i < len[run]; i += 1)
+    {
+      dst[run][i] = src[run][i] * win[run][i];
+    }
+  }
+}
+
+INTERNAL u32
+log_bin_map_count_bands(u32 num_bins, f32 growth)
+{
+  ASSERT(growth > 1.0f);
+
+  u32 num_bands = 0;
+  for (f32 f = 1.0f; (u32)f < num_bins; f = F32_CEIL(f * growth))
+  {
+    num_bands += 1;
+  }
+  return num_bands;
+}
+
+INTERNAL LogBinMap *
+log_bin_map_create(MemArena *arena, u32 num_bins, f32 growth)
+{
+  LogBinMap *map = MEM_ARENA_PUSH_STRUCT_ZERO(arena, LogBinMap);
+  map->num_bins = num_bins;
+  map->growth = growth;
+
+  // NOTE(Ryan): DC is skipped
+  u32 num_bands = log_bin_map_count_bands(num_bins, growth);
+  map->band_start = MEM_ARENA_PUSH_ARRAY(arena, u32, num_bands);
+  map->band_end = MEM_ARENA_PUSH_ARRAY(arena, u32, num_bands);
+  for (f32 f = 1.0f; (u32)f < num_bins; f = F32_CEIL(f * growth))
+  {
+    u32 next = (u32)F32_CEIL(f * growth);
+    map->band_start[map->num_bands] = (u32)f;
+    map->band_end[map->num_bands] = MIN(next, num_bins);
+    map->num_bands += 1;
+  }
+
+  return map;
+}
+
+// NOTE(Ryan): power[i] = |X[i]|^2 for n bins. Returns the largest
+INTERNAL f32
+spectrum_power(f32 *re, f32 *im, f32 *power, u32 n)
+{
+  LaneR32 lane_peak = lane_r32(0.f);
+  u32 i = 0;
+  for (; i + LANE_WIDTH <= n; i += LANE_WIDTH)
+  {
+    LaneR32 r = lane_r32_load(re + i);
+    LaneR32 m = lane_r32_load(im + i);
+    LaneR32 p = lane_fmadd(r, r, m * m);
+    lane_store(power + i, p);
+    lane_peak = lane_max(lane_peak, p);
+  }
+  f32 peak = horizontal_max(lane_peak);
+  for (; i < n; i += 1)
+  {
+    power[i] = SQUARE(re[i]) + SQUARE(im[i]);
+    peak = MAX(peak, power[i]);
+  }
+  return peak;
+}
+
+INTERNAL void
+fast_ln_in_place(f32 *values, u32 count)
+{
+  u32 i = 0;
+  for (; i + LANE_WIDTH <= count; i += LANE_WIDTH)
+  {
+    lane_store(values + i, lane_ln(lane_r32_load(values + i)));
+  }
+  for (; i < count; i += 1)
+  {
+    values[i] = f32_fast_ln(values[i]);
+  }
+}
+
+// NOTE(Ryan): band_max[b] = largest of values over band b's bins
+INTERNAL void
+log_bin_map_band_max(LogBinMap *map, f32 *values, f32 *band_max)
+{
+  for (u32 b = 0; b < map->num_bands; b += 1)
+  {
+    u32 start = map->band_start[b], end = map->band_end[b];
+
+    LaneR32 lane_band_peak = lane_r32(values[start]);
+    u32 j = start;
+    for (; j + LANE_WIDTH <= end; j += LANE_WIDTH)
+    {
+      lane_band_peak = lane_max(lane_band_peak, lane_r32_load(values + j));
+    }
+    f32 band_peak = horizontal_max(lane_band_peak);
+    for (; j < end; j += 1)
+    {
+      band_peak = MAX(band_peak, values[j]);
+    }
+
+    band_max[b] = band_peak;
+  }
+}
+
+// NOTE(Ryan): As ln is monotonic, reduce on the raw power and only take the (approximate) log of the maxima.
+// power requires map->num_bins entries and band_log_power map->num_bands.
+// Returns the log of the largest power over all bins, including DC
+INTERNAL f32
+log_bin_map_reduce(LogBinMap *map, f32 *re, f32 *im, f32 *power, f32 *band_log_power)
+{
+  f32 peak = spectrum_power(re, im, power, map->num_bins);
+  log_bin_map_band_max(map, power, band_log_power);
+  fast_ln_in_place(band_log_power, map->num_bands);
+
+  return f32_fast_ln(peak);
+}
+
+// NOTE(Ryan): Warped frequency scales the filterbanks are spaced evenly on
+INTERNAL f32 hz_to_mel(f32 hz) { return 2595.0f * F32_LOG(10.0f, 1.0f + hz / 700.0f); }
+INTERNAL f32 mel_to_hz(f32 mel) { return 700.0f * (F32_POW(10.0f, mel / 2595.0f) - 1.0f); }
+// NOTE(Ryan): Traunmüller's approximation
+INTERNAL f32 hz_to_bark(f32 hz) { return 26.81f * hz / (1960.0f + hz) - 0.53f; }
+INTERNAL f32 bark_to_hz(f32 bark) { return 1960.0f * (bark + 0.53f) / (26.28f - bark); }
+
+INTERNAL f32 
+filterbank_warp(SPECTRUM_SCALE scale, f32 hz)
+{
+  return (scale == SPECTRUM_SCALE_MEL) ? hz_to_mel(hz) : hz_to_bark(hz);
+}
+
+INTERNAL f32 
+filterbank_unwarp(SPECTRUM_SCALE scale, f32 warped)
+{
+  return (scale == SPECTRUM_SCALE_MEL) ? mel_to_hz(warped) : bark_to_hz(warped);
+}
+
+INTERNAL u32
+filterbank_count(SPECTRUM_SCALE scale, f32 nyquist)
+{
+  f32 highest = MIN(nyquist, FILTERBANK_HIGHEST_HZ);
+  u32 count = 0;
+
+  if (scale == SPECTRUM_SCALE_MEL)
+  {
+    count = FILTERBANK_MEL_FILTERS;
+  }
+  else if (scale == SPECTRUM_SCALE_BARK)
+  {
+    f32 span = hz_to_bark(highest) - hz_to_bark(FILTERBANK_LOWEST_HZ);
+    count = (u32)(span / FILTERBANK_BARK_STEP) - 1;
+  }
+  else if (scale == SPECTRUM_SCALE_CONSTANT_Q)
+  {
+    // NOTE(Ryan): Every centre whose upper edge still fits below highest
+    f32 octaves = F32_LOG(2.0f, highest / FILTERBANK_CQ_LOWEST_HZ);
+    count = (u32)(octaves * FILTERBANK_CQ_BINS_PER_OCTAVE);
+  }
+
+  return count;
+}
+
+// NOTE(Ryan): Mel and Bark filters are triangles whose feet sit on their neighbours' centres.
+// Constant-Q centres are FILTERBANK_CQ_BINS_PER_OCTAVE to the octave, 
+// so each bandwidth is the same fraction of its centre frequency
+INTERNAL void
+filterbank_edges(SPECTRUM_SCALE scale, f32 nyquist, u32 num_filters, u32 k, f32 *lower, f32 *centre, f32 *upper)
+{
+  if (scale == SPECTRUM_SCALE_CONSTANT_Q)
+  {
+    f32 ratio = F32_POW(2.0f, 1.0f / FILTERBANK_CQ_BINS_PER_OCTAVE);
+    *centre = FILTERBANK_CQ_LOWEST_HZ * F32_POW(ratio, (f32)k);
+    *lower = *centre / ratio;
+    *upper = *centre * ratio;
+  }
+  else
+  {
+    f32 lo = filterbank_warp(scale, FILTERBANK_LOWEST_HZ);
+    f32 hi = filterbank_warp(scale, MIN(nyquist, FILTERBANK_HIGHEST_HZ));
+    f32 step = (hi - lo) / (num_filters + 1);
+    *lower = filterbank_unwarp(scale, lo + k * step);
+    *centre = filterbank_unwarp(scale, lo + (k + 1) * step);
+    *upper = filterbank_unwarp(scale, lo + (k + 2) * step);
+  }
+}
+
+// NOTE(Ryan): Non-zero weights of one filter span bins [*first, *last]. 
+// If row is given, weights are written to row[bin], so row is offset by the first bin.
+// Weights peak at 1 on the centre rather than having unit area, so a sinusoid reads the same as in the log bands.
+// A filter narrower than a bin would land between bins and see nothing, 
+// so it instead linearly interpolates the two bins either side of its centre
+INTERNAL void
+filterbank_row(f32 lower, f32 centre, f32 upper, f32 bin_hz, u32 num_bins, f32 *row, u32 *first, u32 *last)
+{
+  *first = U32_MAX;
+  *last = 0;
+
+  u32 start = MAX((u32)F32_CEIL(lower / bin_hz), 1);
+  u32 end = MIN((u32)F32_FLOOR(upper / bin_hz), num_bins - 1);
+  for (u32 j = start; j <= end; j += 1)
+  {
+    f32 f = j * bin_hz;
+    f32 w = (f <= centre) ? (f - lower) / (centre - lower) : (upper - f) / (upper - centre);
+    if (w > 0.f)
+    {
+      if (row != NULL) row[j] = w;
+      *first = MIN(*first, j);
+      *last = j;
+    }
+  }
+
+  if (*first == U32_MAX)
+  {
+    f32 position = centre / bin_hz;
+    u32 below = MIN((u32)position, num_bins - 2);
+    f32 t = CLAMP(0.f, position - below, 1.f);
+    if (row != NULL)
+    {
+      row[below] = 1.0f - t;
+      row[below + 1] = t;
+    }
+    *first = below;
+    *last = below + 1;
+  }
+}
+
+// NOTE(Ryan): Filters sit over num_bins bins of an FFT at sample_rate
+INTERNAL Filterbank *
+filterbank_create(MemArena *arena, SPECTRUM_SCALE scale, u32 num_bins, u32 sample_rate)
+{
+  ASSERT(scale != SPECTRUM_SCALE_LOG_BANDS && sample_rate > 0 && num_bins >= 2);
+
+  Filterbank *bank = MEM_ARENA_PUSH_STRUCT_ZERO(arena, Filterbank);
+  bank->scale = scale;
+  bank->sample_rate = sample_rate;
+  bank->num_bins = num_bins;
+
+  f32 nyquist = sample_rate / 2.0f;
+  f32 bin_hz = nyquist / num_bins;
+  bank->num_filters = filterbank_count(scale, nyquist);
+
+  bank->first_bin = MEM_ARENA_PUSH_ARRAY(arena, u32, bank->num_filters);
+  bank->num_weights = MEM_ARENA_PUSH_ARRAY(arena, u32, bank->num_filters);
+  bank->weight_offset = MEM_ARENA_PUSH_ARRAY(arena, u32, bank->num_filters);
+
+  // NOTE(Ryan): First pass sizes the rows, so the weights can be one contiguous array
+  u32 total = 0;
+  for (u32 k = 0; k < bank->num_filters; k += 1)
+  {
+    f32 lower = 0.f, centre = 0.f, upper = 0.f;
+    filterbank_edges(scale, nyquist, bank->num_filters, k, &lower, &centre, &upper);
+
+    u32 first = 0, last = 0;
+    filterbank_row(lower, centre, upper, bin_hz, num_bins, NULL, &first, &last);
+
+    bank->first_bin[k] = first;
+    bank->num_weights[k] = last - first + 1;
+    bank->weight_offset[k] = total;
+    total += bank->num_weights[k];
+  }
+
+  bank->weights = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, total);
+  for (u32 k = 0; k < bank->num_filters; k += 1)
+  {
+    f32 lower = 0.f, centre = 0.f, upper = 0.f;
+    filterbank_edges(scale, nyquist, bank->num_filters, k, &lower, &centre, &upper);
+
+    u32 first = 0, last = 0;
+    f32 *row = bank->weights + bank->weight_offset[k] - bank->first_bin[k];
+    filterbank_row(lower, centre, upper, bin_hz, num_bins, row, &first, &last);
+  }
+
+  return bank;
+}
+
+// NOTE(Ryan): Sparse mat-vec of the weights against power, then the log of each filter output.
+// Returns the log of the largest filter output
+INTERNAL f32
+filterbank_apply(Filterbank *bank, f32 *power, f32 *filter_log_power)
+{
+  f32 peak = 0.f;
+
+  for (u32 k = 0; k < bank->num_filters; k += 1)
+  {
+    f32 *weights = bank->weights + bank->weight_offset[k];
+    f32 *bins = power + bank->first_bin[k];
+    u32 count = bank->num_weights[k];
+
+    LaneR32 lane_sum = lane_r32(0.f);
+    u32 j = 0;
+    for (; j + LANE_WIDTH <= count; j += LANE_WIDTH)
+    {
+      lane_sum = lane_fmadd(lane_r32_load(weights + j), lane_r32_load(bins + j), lane_sum);
+    }
+    f32 sum = horizontal_add(lane_sum);
+    for (; j < count; j += 1)
+    {
+      sum += weights[j] * bins[j];
+    }
+
+    filter_log_power[k] = sum;
+    peak = MAX(peak, sum);
+  }
+  fast_ln_in_place(filter_log_power, bank->num_filters);
+
+  return f32_fast_ln(peak);
+}
+
+
+// NOTE(Ryan): Pitch class of a frequency, rounding to the nearest semitone
+INTERNAL u32
+chroma_class_from_hz(f32 hz)
+{
+  s32 semitones = F32_ROUND_S32(12.0f * F32_LOG(2.0f, hz / CHROMA_REFERENCE_HZ)) + CHROMA_REFERENCE_CLASS;
+  return (u32)(((semitones % CHROMA_BINS) + CHROMA_BINS) % CHROMA_BINS);
+}
+
+INTERNAL ChromaMap *
+chroma_map_create(MemArena *arena, u32 num_bins, u32 sample_rate)
+{
+  ChromaMap *map = MEM_ARENA_PUSH_STRUCT_ZERO(arena, ChromaMap);
+  map->sample_rate = sample_rate;
+
+  f32 bin_hz = (sample_rate / 2.0f) / num_bins;
+  // NOTE(Ryan): Width of a semitone centred on f is f * (2^(1/24) - 2^(-1/24))
+  f32 semitone_width = F32_POW(2.0f, 1.0f / 24.0f) - F32_POW(2.0f, -1.0f / 24.0f);
+  f32 lowest = MAX(CHROMA_LOWEST_HZ, bin_hz / semitone_width);
+  u32 first = MAX((u32)F32_CEIL(lowest / bin_hz), 1);
+  u32 end = MIN((u32)F32_FLOOR(CHROMA_HIGHEST_HZ / bin_hz) + 1, num_bins);
+  if (first >= end) return map;
+
+  // NOTE(Ryan): A run per semitone crossed, plus one for the partial semitone at the start
+  u32 max_runs = (u32)F32_CEIL(12.0f * F32_LOG(2.0f, (f32)end / first)) + 2;
+  map->run_start = MEM_ARENA_PUSH_ARRAY(arena, u32, max_runs);
+  map->run_end = MEM_ARENA_PUSH_ARRAY(arena, u32, max_runs);
+  map->run_class = MEM_ARENA_PUSH_ARRAY(arena, u32, max_runs);
+
+  for (u32 j = first; j < end; j += 1)
+  {
+    u32 pitch_class = chroma_class_from_hz(j * bin_hz);
+    if (map->num_runs == 0 || map->run_class[map->num_runs - 1] != pitch_class)
+    {
+      ASSERT(map->num_runs < max_runs);
+      map->run_start[map->num_runs] = j;
+      map->run_class[map->num_runs] = pitch_class;
+      map->num_runs += 1;
+    }
+    map->run_end[map->num_runs - 1] = j + 1;
+  }
+
+  return map;
+}
+
+// NOTE(Ryan): Sums power into the pitch class of each bin, then normalises to sum to 1
+INTERNAL void
+chroma_map_accumulate(ChromaMap *map, f32 *power, f32 *chroma)
+{
+  for (u32 c = 0; c < CHROMA_BINS; c += 1) chroma[c] = 0.f;
+
+  for (u32 r = 0; r < map->num_runs; r += 1)
+  {
+    u32 start = map->run_start[r], end = map->run_end[r];
+
+    LaneR32 lane_sum = lane_r32(0.f);
+    u32 j = start;
+    for (; j + LANE_WIDTH <= end; j += LANE_WIDTH)
+    {
+      lane_sum += lane_r32_load(power + j);
+    }
+    f32 sum = horizontal_add(lane_sum);
+    for (; j < end; j += 1)
+    {
+      sum += power[j];
+    }
+
+    chroma[map->run_class[r]] += sum;
+  }
+
+  f32 total = 0.f;
+  for (u32 c = 0; c < CHROMA_BINS; c += 1) total += chroma[c];
+  if (total > 0.f)
+  {
+    for (u32 c = 0; c < CHROMA_BINS; c += 1) chroma[c] /= total;
+  }
+}
+
+INTERNAL void
+spectrum_frame_init(MemArena *arena, SpectrumFrame *frame, u32 max_bands)
+{
+  frame->end_sample = 0;
+  frame->hop = 1;
+  frame->max_log_power = 1.0f;
+  frame->num_bands = max_bands;
+  frame->max_bands = max_bands;
+  frame->band_log_power = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, max_bands);
+}
+
+INTERNAL void
+spectrum_frame_copy(SpectrumFrame *dst, SpectrumFrame *src)
+{
+  ASSERT(src->num_bands <= dst->max_bands);
+  dst->end_sample = src->end_sample;
+  dst->hop = src->hop;
+  dst->scale = src->scale;
+  dst->tempo_bpm = src->tempo_bpm;
+  dst->tempo_confidence = src->tempo_confidence;
+  MEMORY_COPY(dst->chroma, src->chroma, sizeof(dst->chroma));
+  dst->key = src->key;
+  dst->key_confidence = src->key_confidence;
+  dst->max_log_power = src->max_log_power;
+  dst->num_bands = src->num_bands;
+  MEMORY_COPY(dst->band_log_power, src->band_log_power, src->num_bands * sizeof(f32));
+}
+
+// NOTE(Ryan): Give either a bin map or a filterbank.
+// A bin map may be laid out on a grid a power of two finer than this size's bins, which refines peaks onto it
+INTERNAL STFT *
+stft_create(MemArena *arena, u32 size, u32 hop, LogBinMap *bin_map, Filterbank *filterbank)
+{
+  ASSERT(hop > 0 && hop <= size);
+  ASSERT((bin_map == NULL) != (filterbank == NULL));
+  ASSERT(bin_map == NULL || (IS_POW2(bin_map->num_bins) && bin_map->num_bins >= size / 2));
+  ASSERT(filterbank == NULL || filterbank->num_bins == size / 2);
+
+  STFT *stft = MEM_ARENA_PUSH_STRUCT_ZERO(arena, STFT);
+  stft->size = size;
+  stft->hop = hop;
+  stft->next_frame_end = size;
+
+  stft->plan = rfft_plan_create(arena, size);
+  stft->windows = window_table_create(arena, size);
+  stft->bin_map = bin_map;
+  stft->filterbank = filterbank;
+  stft->num_bands = (filterbank != NULL) ? filterbank->num_filters : bin_map->num_bands;
+  stft->windowed = MEM_ARENA_PUSH_ARRAY(arena, f32, size);
+  stft->re = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2 + 1);
+  stft->im = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2 + 1);
+  stft->power = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2);
+
+  stft->refine_factor = (bin_map != NULL) ? bin_map->num_bins / (size / 2) : 1;
+  if (stft->refine_factor > 1)
+  {
+    window_table_add_derivatives(arena, stft->windows);
+    stft->log_power = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2);
+    stft->fine_log_power = MEM_ARENA_PUSH_ARRAY(arena, f32, bin_map->num_bins);
+    stft->derivative_re = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2 + 1);
+    stft->derivative_im = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2 + 1);
+  }
+
+  stft->peak_log_power = 1.0f;
+  stft->band_log_power = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, stft->num_bands);
+
+  return stft;
+}
+
+// NOTE(Ryan): A cosine sum of k terms has the first zeros of its main lobe k bins either side
+INTERNAL u32
+window_lobe_bins(WINDOW window)
+{
+  u32 num_terms = 0;
+  for (u32 k = 0; k < ARRAY_COUNT(g_window_cosine_terms[window]); k += 1)
+  {
+    if (!f64_eq(g_window_cosine_terms[window][k], 0.0)) num_terms = k + 1;
+  }
+  return num_terms;
+}
+
+// NOTE(Ryan): Where the peak at bin i lies, in bins from i, and the parabola through it and its neighbours
+// as y(x) = height + curve*(x - offset)^2
+INTERNAL f32
+stft_refine_peak(STFT *stft, u32 i, PEAK_REFINE refine, f32 *height, f32 *curve)
+{
+  f32 alpha = stft->log_power[i - 1], beta = stft->log_power[i], gamma = stft->log_power[i + 1];
+
+  // NOTE(Ryan): y(x) = beta + slope*x + bend*x^2 through the three bins at x = -1, 0, 1
+  f32 slope = 0.5f * (gamma - alpha);
+  f32 bend = 0.5f * (alpha + gamma) - beta;
+  f32 offset = -0.5f * slope / bend;
+  if (refine == PEAK_REFINE_REASSIGN)
+  {
+    // NOTE(Ryan): -Im(Xd / X), with the derivative window scaled to give it in bins
+    f32 re = stft->re[i], im = stft->im[i];
+    f32 cross = stft->derivative_im[i] * re - stft->derivative_re[i] * im;
+    offset = -cross / (SQUARE(re) + SQUARE(im));
+  }
+  offset = CLAMP(-0.5f, offset, 0.5f);
+
+  *height = beta + offset * (slope + bend * offset);
+  *curve = bend;
+  return offset;
+}
+
+// NOTE(Ryan): Spreads the frame's log power onto the bin map's finer grid, see PEAK_REFINE.
+// The grid is linearly interpolated between bins, except that each peak's main lobe is taken out,
+// bridged across from the bins just outside it, and the peak is drawn back in on top 
+// as its parabola narrowed by the refine factor. So the lobe has the width the finer grid would give it,
+// and a weaker partial beside the lobe isn't lost under it.
+// Both passes are a min or max, so overlapping lobes come out the same in any order.
+// Returns the largest value written
+INTERNAL f32
+stft_refine(STFT *stft, WINDOW window, PEAK_REFINE refine)
+{
+  u32 num_bins = stft->size / 2;
+  u32 factor = stft->refine_factor;
+  f32 inv_factor = 1.0f / factor;
+  f32 *coarse = stft->log_power;
+  f32 *fine = stft->fine_log_power;
+
+  MEMORY_COPY(coarse, stft->power, num_bins * sizeof(f32));
+  fast_ln_in_place(coarse, num_bins);
+
+  for (u32 i = 0; i < num_bins; i += 1)
+  {
+    f32 from = coarse[i];
+    f32 step = (refine == PEAK_REFINE_NONE || i + 1 == num_bins) ? 0.0f : (coarse[i + 1] - from) * inv_factor;
+    f32 *out = fine + i * factor;
+    for (u32 j = 0; j < factor; j += 1)
+    {
+      out[j] = from + step * j;
+    }
+  }
+  f32 peak = coarse[0];
+  for (u32 i = 1; i < num_bins; i += 1) peak = MAX(peak, coarse[i]);
+  if (refine == PEAK_REFINE_NONE) return peak;
+
+  f32 lobe = (f32)window_lobe_bins(window);
+  f32 narrowing = (f32)SQUARE(factor);
+  for (u32 pass = 0; pass < 2; pass += 1)
+  {
+    for (u32 i = 1; i + 1 < num_bins; i += 1)
+    {
+      if (!(coarse[i] > coarse[i - 1] && coarse[i] >= coarse[i + 1])) continue;
+
+      f32 height = 0.f, curve = 0.f;
+      f32 offset = stft_refine_peak(stft, i, refine, &height, &curve);
+      f32 centre = (f32)i + offset;
+      u32 first = (u32)MAX(0.0f, F32_FLOOR(centre - lobe));
+      u32 last = (u32)MIN((f32)(num_bins - 1), F32_CEIL(centre + lobe));
+
+      f32 *out = fine + first * factor;
+      s32 count = (s32)((last - first) * factor + 1);
+      if (pass == 0)
+      {
+        f32 from = coarse[first];
+        f32 step = (coarse[last] - from) / (f32)(count - 1);
+        for (s32 j = 0; j < count; j += 1)
+        {
+          out[j] = MIN(out[j], from + step * (f32)j);
+        }
+      }
+      else
+      {
+        peak = MAX(peak, height);
+        f32 narrow_curve = curve * narrowing;
+        f32 start = (f32)first - centre;
+        for (s32 j = 0; j < count; j += 1)
+        {
+          f32 d = start + (f32)j * inv_factor;
+          out[j] = MAX(out[j], height + narrow_curve * d * d);
+        }
+      }
+    }
+  }
+
+  return peak;
+}
+
+// NOTE(Ryan): num_written is the total count of samples the ring has ever received.
+// Analyses the window ending on the most recent completed hop, if any, skipping older hops
+// that would be superseded before being seen. Returns whether a new frame was analysed
+INTERNAL b32
+stft_update(STFT *stft, f32 *ring, u32 ring_count, u64 num_written, WINDOW window, 
+            PEAK_REFINE refine = PEAK_REFINE_QUADRATIC)
+{
+  ASSERT(IS_POW2(ring_count) && ring_count >= 2 * stft->size);
+
+  if (num_written < stft->next_frame_end) return false;
+
+  u64 hops_behind = (num_written - stft->next_frame_end) / stft->hop;
+  u64 frame_end = stft->next_frame_end + hops_behind * stft->hop;
+  stft->next_frame_end = frame_end + stft->hop;
+
+  // IMPORTANT(Ryan): Requires the writer to be less than ring_count - size samples past frame_end,
+  // so the window isn't overwritten while it's being read
+  u32 start = (u32)((frame_end - stft->size) & (ring_count - 1));
+  window_apply_ring(stft->windowed, stft->windows->coefficients[window], stft->size, ring, ring_count, start);
+  rfft_execute(stft->plan, stft->windowed, stft->re, stft->im);
+
+  stft->frame_end = frame_end;
+  if (stft->filterbank != NULL)
+  {
+    spectrum_power(stft->re, stft->im, stft->power, stft->size / 2);
+    stft->peak_log_power = filterbank_apply(stft->filterbank, stft->power, stft->band_log_power);
+  }
+  else if (stft->refine_factor > 1)
+  {
+    if (refine == PEAK_REFINE_REASSIGN)
+    {
+      window_apply_ring(stft->windowed, stft->windows->derivatives[window], stft->size, ring, ring_count, start);
+      rfft_execute(stft->plan, stft->windowed, stft->derivative_re, stft->derivative_im);
+    }
+    spectrum_power(stft->re, stft->im, stft->power, stft->size / 2);
+    stft->peak_log_power = stft_refine(stft, window, refine);
+    log_bin_map_band_max(stft->bin_map, stft->fine_log_power, stft->band_log_power);
+  }
+  else
+  {
+    stft->peak_log_power = log_bin_map_reduce(stft->bin_map, stft->re, stft->im,
+                                              stft->power, stft->band_log_power);
+  }
+  stft->num_frames += 1;
+
+  return true;
+}
+
+// NOTE(Ryan): Bands [first, first + count) of map, re-expressed in the bins of an FFT decimation times shorter.
+// Widened outwards so no part of a band is lost, and kept at least a bin wide
+INTERNAL LogBinMap *
+log_bin_map_slice(MemArena *arena, LogBinMap *map, u32 first, u32 count, u32 decimation)
+{
+  ASSERT(first + count <= map->num_bands && IS_POW2(decimation));
+
+  LogBinMap *slice = MEM_ARENA_PUSH_STRUCT_ZERO(arena, LogBinMap);
+  slice->num_bins = map->num_bins / decimation;
+  slice->growth = map->growth;
+  slice->num_bands = count;
+  slice->band_start = MEM_ARENA_PUSH_ARRAY(arena, u32, count);
+  slice->band_end = MEM_ARENA_PUSH_ARRAY(arena, u32, count);
+  for (u32 b = 0; b < count; b += 1)
+  {
+    u32 start = map->band_start[first + b] / decimation;
+    u32 end = (map->band_end[first + b] + decimation - 1) / decimation;
+    slice->band_start[b] = MIN(start, slice->num_bins - 1);
+    slice->band_end[b] = CLAMP(slice->band_start[b] + 1, end, slice->num_bins);
+  }
+
+  return slice;
+}
+
+// NOTE(Ryan): sample_rate is only used by the filterbank scales
+INTERNAL SpectrumAnalyser *
+spectrum_analyser_create(MemArena *arena, u32 size, f32 bin_growth, SPECTRUM_SCALE scale, u32 sample_rate)
+{
+  SpectrumAnalyser *analyser = MEM_ARENA_PUSH_STRUCT_ZERO(arena, SpectrumAnalyser);
+  analyser->size = size;
+  analyser->scale = scale;
+  analyser->sample_rate = sample_rate;
+  analyser->chroma_map = chroma_map_create(arena, size / 2, sample_rate);
+
+  // NOTE(Ryan): A filterbank already sums many bins into each wide filter, 
+  // so a single FFT at the full size is enough, and cheaper than the two log band layers
+  if (scale != SPECTRUM_SCALE_LOG_BANDS)
+  {
+    Filterbank *bank = filterbank_create(arena, scale, size / 2, sample_rate);
+    analyser->num_bands = bank->num_filters;
+    SpectrumLayer *layer = &analyser->layers[analyser->num_layers++];
+    layer->stft = stft_create(arena, size, size / FFT_HOP_DIVISOR, NULL, bank);
+    return analyser;
+  }
+
+  // NOTE(Ryan): Short FFTs keep the bands of SPECTRUM_REFINE_TO_SIZE, with the long layer's peaks refined onto them
+  u32 refine = MAX(1, SPECTRUM_REFINE_TO_SIZE / size);
+  LogBinMap *map = log_bin_map_create(arena, size / 2 * refine, bin_growth);
+  analyser->num_bands = map->num_bands;
+
+  // NOTE(Ryan): Hand over to the short FFT once a band spans at least one of its bins
+  u32 decimation = SPECTRUM_SHORT_SIZE_DIVISOR;
+  u32 crossover = map->num_bands;
+  if (size >= SPECTRUM_MULTI_RES_MIN_SIZE)
+  {
+    for (u32 b = 0; b < map->num_bands; b += 1)
+    {
+      if (map->band_end[b] - map->band_start[b] >= decimation * refine)
+      {
+        crossover = b;
+        break;
+      }
+    }
+  }
+
+  SpectrumLayer *lows = &analyser->layers[analyser->num_layers++];
+  lows->first_band = 0;
+  lows->log_gain = 0.0f;
+  if (crossover == map->num_bands)
+  {
+    lows->stft = stft_create(arena, size, size / FFT_HOP_DIVISOR, map, NULL);
+  }
+  else
+  {
+    LogBinMap *low_map = log_bin_map_slice(arena, map, 0, crossover, 1);
+    lows->stft = stft_create(arena, size, size / FFT_HOP_DIVISOR, low_map, NULL);
+
+    u32 short_size = size / decimation;
+    SpectrumLayer *highs = &analyser->layers[analyser->num_layers++];
+    LogBinMap *high_map = log_bin_map_slice(arena, map, crossover, map->num_bands - crossover, decimation * refine);
+    highs->stft = stft_create(arena, short_size, short_size / FFT_HOP_DIVISOR, high_map, NULL);
+    highs->first_band = crossover;
+    // NOTE(Ryan): A sinusoid's peak power grows with the square of the FFT size
+    highs->log_gain = 2.0f * F32_LN((f32)decimation);
+  }
+
+  return analyser;
+}
+
+// NOTE(Ryan): Each layer runs on its own hop. A frame is produced whenever the shortest hop completes,
+// taking the most recent result of every layer. As hops are all size / FFT_HOP_DIVISOR, 
+// every long hop boundary is also a short one, so layers line up in time
+INTERNAL b32
+spectrum_analyser_update(SpectrumAnalyser *analyser, f32 *ring, u32 ring_count, u64 num_written, 
+                         WINDOW window, SpectrumFrame *frame, PEAK_REFINE refine = PEAK_REFINE_QUADRATIC)
+{
+  ASSERT(analyser->num_bands <= frame->max_bands);
+
+  b32 paced = false;
+  for (u32 l = 0; l < analyser->num_layers; l += 1)
+  {
+    STFT *stft = analyser->layers[l].stft;
+    b32 updated = stft_update(stft, ring, ring_count, num_written, window, refine);
+    if (l == 0 && updated) chroma_map_accumulate(analyser->chroma_map, stft->power, analyser->chroma);
+    if (l == analyser->num_layers - 1) paced = updated;
+  }
+  if (!paced) return false;
+
+  STFT *pace = analyser->layers[analyser->num_layers - 1].stft;
+  frame->end_sample = pace->frame_end;
+  frame->hop = pace->hop;
+  frame->scale = analyser->scale;
+  MEMORY_COPY(frame->chroma, analyser->chroma, sizeof(frame->chroma));
+  frame->num_bands = analyser->num_bands;
+  frame->max_log_power = f32_neg_inf();
+
+  for (u32 l = 0; l < analyser->num_layers; l += 1)
+  {
+    SpectrumLayer *layer = &analyser->layers[l];
+    STFT *stft = layer->stft;
+    f32 *bands = frame->band_log_power + layer->first_band;
+    for (u32 b = 0; b < stft->num_bands; b += 1)
+    {
+      bands[b] = stft->band_log_power[b] + layer->log_gain;
+    }
+    frame->max_log_power = MAX(frame->max_log_power, stft->peak_log_power + layer->log_gain);
+  }
+
+  return true;
+}
+
+INTERNAL void
+spectrum_history_init(MemArena *arena, SpectrumHistory *history, u32 max_bands)
+{
+  history->latest = 0;
+  history->num_frames = 0;
+  for (u32 i = 0; i < ARRAY_COUNT(history->frames); i += 1)
+  {
+    spectrum_frame_init(arena, &history->frames[i], max_bands);
+  }
+}
+
+INTERNAL void
+spectrum_history_push(SpectrumHistory *history, SpectrumFrame *frame)
+{
+  // NOTE(Ryan): Bands aren't comparable across FFT sizes or scales, so start afresh rather than interpolate
+  SpectrumFrame *latest = &history->frames[history->latest];
+  b32 resized = (frame->num_bands != latest->num_bands || frame->scale != latest->scale);
+
+  history->latest ^= 1;
+  spectrum_frame_copy(&history->frames[history->latest], frame);
+  if (resized) spectrum_frame_copy(&history->frames[history->latest ^ 1], frame);
+  history->num_frames += 1;
+}
+
+// NOTE(Ryan): How far playback has moved from the previous frame towards the latest, in [0, 1].
+// Rendering at this point between the two trails the audio by one hop, but never has to extrapolate
+INTERNAL f32
+spectrum_history_t(SpectrumHistory *history, u64 num_written)
+{
+  if (history->num_frames < 2) return 1.0f;
+
+  SpectrumFrame *latest = &history->frames[history->latest];
+  if (num_written <= latest->end_sample) return 0.0f;
+
+  f32 t = (f32)(num_written - latest->end_sample) / (f32)latest->hop;
+  return MIN(t, 1.0f);
+}
+
+INTERNAL void
+spectrum_smoothing_init(MemArena *arena, SpectrumSmoothing *smoothing, u32 max_bands)
+{
+  smoothing->levels = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, max_bands);
+  smoothing->peaks = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, max_bands);
+  smoothing->peak_holds = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, max_bands);
+}
+
+// NOTE(Ryan): Moves every band dt seconds towards the spectrum between previous and latest at frame_t, 
+// normalised to its loudest bin. One pass does the interpolation, smoothing and peaks together
+INTERNAL void
+spectrum_smoothing_update(SpectrumSmoothing *smoothing, SpectrumFrame *previous, SpectrumFrame *latest, 
+                          f32 frame_t, f32 dt)
+{
+  f32 max_power = f32_lerp(previous->max_log_power, latest->max_log_power, frame_t);
+  f32 inv_max_power = 1.0f / MAX(max_power, 1.0f);
+  f32 attack = 1.0f - f32_fast_exp(-dt / SMOOTHING_ATTACK_SECONDS);
+  f32 release = 1.0f - f32_fast_exp(-dt / SMOOTHING_RELEASE_SECONDS);
+  f32 fall = PEAK_FALL_PER_SECOND * dt;
+
+  f32 *levels = smoothing->levels, *peaks = smoothing->peaks, *holds = smoothing->peak_holds;
+  f32 *prev_power = previous->band_log_power, *next_power = latest->band_log_power;
+  u32 num_bands = latest->num_bands;
+
+  LaneR32 lane_t = lane_r32(frame_t), lane_inv_max = lane_r32(inv_max_power), zero = lane_r32(0.f);
+  LaneR32 lane_attack = lane_r32(attack), lane_release = lane_r32(release);
+  LaneR32 lane_dt = lane_r32(dt), lane_fall = lane_r32(fall), lane_hold = lane_r32(PEAK_HOLD_SECONDS);
+  u32 j = 0;
+  for (; j + LANE_WIDTH <= num_bands; j += LANE_WIDTH)
+  {
+    LaneR32 prev = lane_r32_load(prev_power + j);
+    LaneR32 target = lane_fmadd(lane_r32_load(next_power + j) - prev, lane_t, prev);
+    target = lane_max(target, zero) * lane_inv_max;
+
+    LaneR32 level = lane_r32_load(levels + j);
+    LaneR32 rate = lane_select(target > level, lane_release, lane_attack);
+    level = lane_fmadd(target - level, rate, level);
+
+    LaneR32 peak = lane_r32_load(peaks + j), hold = lane_r32_load(holds + j);
+    LaneU32 rising = level > peak;
+    LaneR32 fallen = lane_max(peak - lane_select(hold > zero, lane_fall, zero), level);
+    peak = lane_select(rising, fallen, level);
+    hold = lane_select(rising, hold - lane_dt, lane_hold);
+
+    lane_store(levels + j, level);
+    lane_store(peaks + j, peak);
+    lane_store(holds + j, hold);
+  }
+  for (; j < num_bands; j += 1)
+  {
+    f32 target = MAX(f32_lerp(prev_power[j], next_power[j], frame_t), 0.f) * inv_max_power;
+    levels[j] += (target - levels[j]) * ((target > levels[j]) ? attack : release);
+
+    if (levels[j] > peaks[j])
+    {
+      peaks[j] = levels[j];
+      holds[j] = PEAK_HOLD_SECONDS;
+    }
+    else
+    {
+      if (holds[j] <= 0.f) peaks[j] = MAX(peaks[j] - fall, levels[j]);
+      holds[j] -= dt;
+    }
+  }
+}
+
+INTERNAL void
+spectrum_exchange_init(MemArena *arena, SpectrumExchange *exchange, u32 max_bands)
+{
+  for (u32 i = 0; i < ARRAY_COUNT(exchange->slots); i += 1)
+  {
+    spectrum_frame_init(arena, &exchange->slots[i], max_bands);
+  }
+  exchange->back = 0;
+  exchange->middle = 1;
+  exchange->front = 2;
+}
+
+// NOTE(Ryan): Writer side. Fill this slot, then publish it
+INTERNAL SpectrumFrame *
+spectrum_exchange_back(SpectrumExchange *exchange)
+{
+  return &exchange->slots[exchange->back];
+}
+
+INTERNAL void
+spectrum_exchange_publish(SpectrumExchange *exchange)
+{
+  u32 previous = atomic_u32_exchange(&exchange->middle, exchange->back | SPECTRUM_EXCHANGE_FRESH);
+  exchange->back = previous & ~SPECTRUM_EXCHANGE_FRESH;
+}
+
+// NOTE(Ryan): Reader side. Returns NULL if nothing new has been published since last time.
+// The returned slot stays untouched by the writer until the next acquire
+INTERNAL SpectrumFrame *
+spectrum_exchange_acquire(SpectrumExchange *exchange)
+{
+  if (!(atomic_u32_load(&exchange->middle) & SPECTRUM_EXCHANGE_FRESH)) return NULL;
+
+  u32 previous = atomic_u32_exchange(&exchange->middle, exchange->front);
+  exchange->front = previous & ~SPECTRUM_EXCHANGE_FRESH;
+  return &exchange->slots[exchange->front];
+}
+
+INTERNAL void
+onset_detector_init(MemArena *arena, OnsetDetector *detector, u32 max_bands)
+{
+  detector->max_bands = max_bands;
+  detector->previous_bands = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, max_bands);
+}
+
+// NOTE(Ryan): Mean rise in floored log power over the bands, ignoring falls. 
+// Also makes current the previous frame for next time
+INTERNAL f32
+spectral_flux(f32 *previous, f32 *current, u32 num_bands)
+{
+  LaneR32 lane_floor_power = lane_r32(ONSET_LOG_POWER_FLOOR);
+  LaneR32 lane_sum = lane_r32(0.f);
+  u32 b = 0;
+  for (; b + LANE_WIDTH <= num_bands; b += LANE_WIDTH)
+  {
+    LaneR32 now = lane_max(lane_r32_load(current + b), lane_floor_power);
+    LaneR32 before = lane_r32_load(previous + b);
+    lane_sum += lane_max(now - before, lane_r32(0.f));
+    lane_store(previous + b, now);
+  }
+  f32 sum = horizontal_add(lane_sum);
+  for (; b < num_bands; b += 1)
+  {
+    f32 now = MAX(current[b], ONSET_LOG_POWER_FLOOR);
+    sum += MAX(now - previous[b], 0.f);
+    previous[b] = now;
+  }
+
+  return sum / num_bands;
+}
+
+// NOTE(Ryan): Octave-folds the gap since the last onset into the beat range and folds that into the period.
+// The beat grid is re-anchored on onsets that land near a predicted beat, or if it hasn't been for a while
+INTERNAL void
+onset_detector_track_beat(OnsetDetector *detector, u64 onset, u32 sample_rate)
+{
+  f32 min_period = BEAT_PERIOD_MIN_SECONDS * sample_rate;
+  f32 max_period = BEAT_PERIOD_MAX_SECONDS * sample_rate;
+
+  if (detector->last_onset != 0)
+  {
+    f32 interval = (f32)(onset - detector->last_onset);
+    // NOTE(Ryan): A long silence says nothing about tempo
+    if (interval <= 4.0f * max_period)
+    {
+      while (interval < min_period) interval *= 2.0f;
+      while (interval > max_period) interval *= 0.5f;
+
+      if (detector->beat_period <= 0.f) detector->beat_period = interval;
+      else detector->beat_period += (interval - detector->beat_period) * BEAT_PERIOD_SMOOTHING;
+    }
+  }
+  detector->last_onset = onset;
+
+  if (detector->beat_period <= 0.f || detector->beat_anchor == 0)
+  {
+    detector->beat_anchor = onset;
+  }
+  else
+  {
+    f32 beats = (onset - detector->beat_anchor) / detector->beat_period;
+    f32 off_beat = beats - F32_ROUND(beats);
+    if (f32_abs(off_beat) < 0.25f || beats > 8.0f) detector->beat_anchor = onset;
+  }
+}
+
+// NOTE(Ryan): O(bands) per frame. A flux peak can only be confirmed once the next frame is lower,
+// so onsets are reported one hop late, stamped with the end sample of the frame they peaked on.
+// Returns whether an onset was confirmed, and if so its timestamp in onset
+INTERNAL b32
+onset_detector_update(OnsetDetector *detector, SpectrumFrame *frame, u32 sample_rate, u64 *onset)
+{
+  ASSERT(frame->num_bands <= detector->max_bands);
+
+  // NOTE(Ryan): Flux between different sizes or scales is meaningless, so start over
+  if (frame->num_bands != detector->num_bands || frame->scale != detector->scale)
+  {
+    detector->num_bands = frame->num_bands;
+    detector->scale = frame->scale;
+    detector->has_previous = false;
+    detector->num_flux = 0;
+  }
+  detector->strength = 0.f;
+
+  if (!detector->has_previous)
+  {
+    for (u32 b = 0; b < frame->num_bands; b += 1)
+    {
+      detector->previous_bands[b] = MAX(frame->band_log_power[b], ONSET_LOG_POWER_FLOOR);
+    }
+    detector->has_previous = true;
+    detector->previous_end_sample = frame->end_sample;
+    return false;
+  }
+
+  f32 flux = spectral_flux(detector->previous_bands, frame->band_log_power, frame->num_bands);
+  detector->strength = flux;
+  u64 n = detector->num_flux++;
+  detector->flux[n % ONSET_MEDIAN_FRAMES] = flux;
+
+  u64 candidate_end = detector->previous_end_sample;
+  detector->previous_end_sample = frame->end_sample;
+  if (n < 2) return false;
+
+  u32 count = (u32)MIN(n + 1, ONSET_MEDIAN_FRAMES);
+  for (u32 i = 0; i < count; i += 1)
+  {
+    f32 value = detector->flux[i];
+    u32 j = i;
+    for (; j > 0 && detector->sorted[j - 1] > value; j -= 1)
+    {
+      detector->sorted[j] = detector->sorted[j - 1];
+    }
+    detector->sorted[j] = value;
+  }
+  f32 threshold = detector->sorted[count / 2] * ONSET_THRESHOLD_SCALE + ONSET_THRESHOLD_OFFSET;
+
+  f32 candidate = detector->flux[(n - 1) % ONSET_MEDIAN_FRAMES];
+  f32 before = detector->flux[(n - 2) % ONSET_MEDIAN_FRAMES];
+  b32 is_peak = (candidate > threshold && candidate >= before && candidate > flux);
+
+  u64 min_gap = (u64)(ONSET_MIN_GAP_SECONDS * sample_rate);
+  b32 spaced = (detector->last_onset == 0 || candidate_end >= detector->last_onset + min_gap);
+  if (!is_peak || !spaced) return false;
+
+  onset_detector_track_beat(detector, candidate_end, sample_rate);
+  *onset = candidate_end;
+  return true;
+}
+
+INTERNAL void
+onset_track_publish(OnsetTrack *track, OnsetDetector *detector, u64 onset)
+{
+  u64 index = atomic_u64_load(&track->num_onsets);
+  atomic_u64_store(&track->onset_samples[index % ONSET_HISTORY], &onset);
+  u32 beat_period = (u32)detector->beat_period;
+  atomic_u32_store(&track->beat_period, &beat_period);
+  atomic_u64_store(&track->beat_anchor, &detector->beat_anchor);
+  index += 1;
+  atomic_u64_store(&track->num_onsets, &index);
+}
+
+// NOTE(Ryan): Where now falls between beats, in [0, 1). 0 if the beat isn't known yet
+INTERNAL f32
+onset_track_beat_phase(OnsetTrack *track, u64 now)
+{
+  u32 period = atomic_u32_load(&track->beat_period);
+  u64 anchor = atomic_u64_load(&track->beat_anchor);
+  if (period == 0 || now < anchor) return 0.0f;
+
+  return (f32)((now - anchor) % period) / period;
+}
+
+INTERNAL void
+tempo_estimator_init(MemArena *arena, TempoEstimator *tempo)
+{
+  u32 n = 2 * TEMPO_ENVELOPE_SLOTS;
+  tempo->plan = rfft_plan_create(arena, n);
+  tempo->padded = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  tempo->re = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 2 + 1);
+  tempo->im = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 2 + 1);
+}
+
+// NOTE(Ryan): Autocorrelation is the inverse transform of the power spectrum. 
+// Power is real and even, so its inverse is just a forward real transform of it mirrored, over n
+INTERNAL void
+tempo_estimator_update(TempoEstimator *tempo)
+{
+  u32 slots = TEMPO_ENVELOPE_SLOTS;
+  u32 n = 2 * slots;
+  u32 count = (u32)MIN(tempo->num_slots, slots);
+
+  // NOTE(Ryan): Oldest first, with the mean removed so the constant part doesn't swamp the peaks
+  f32 mean = 0.f;
+  for (u32 i = 0; i < count; i += 1)
+  {
+    mean += tempo->envelope[(tempo->last_slot + 1 - count + i) % slots];
+  }
+  mean /= count;
+  for (u32 i = 0; i < n; i += 1)
+  {
+    tempo->padded[i] = (i < count) ? tempo->envelope[(tempo->last_slot + 1 - count + i) % slots] - mean : 0.f;
+  }
+
+  rfft_execute(tempo->plan, tempo->padded, tempo->re, tempo->im);
+  for (u32 k = 0; k <= n / 2; k += 1)
+  {
+    f32 power = SQUARE(tempo->re[k]) + SQUARE(tempo->im[k]);
+    tempo->padded[k] = power;
+    if (k > 0 && k < n / 2) tempo->padded[n - k] = power;
+  }
+  rfft_execute(tempo->plan, tempo->padded, tempo->re, tempo->im);
+  // NOTE(Ryan): re[lag] is now n times the autocorrelation at lag
+  f32 *acf = tempo->re;
+
+  f32 slots_per_minute = 60.0f * tempo->sample_rate / TEMPO_ENVELOPE_HOP;
+  u32 min_lag = (u32)F32_FLOOR(slots_per_minute / TEMPO_MAX_BPM);
+  u32 max_lag = MIN((u32)F32_CEIL(slots_per_minute / TEMPO_MIN_BPM), count / 2);
+
+  tempo->confidence = 0.f;
+  if (acf[0] <= 0.f || min_lag < 1 || max_lag <= min_lag + 1) return;
+
+  // NOTE(Ryan): A period that isn't a whole number of slots splits its peak across neighbouring lags,
+  // which would favour multiples of it that happen to land closer to whole. So score a smoothed autocorrelation
+  u32 best_lag = 0;
+  f32 best_score = 0.f;
+  for (u32 lag = min_lag; lag <= max_lag; lag += 1)
+  {
+    f32 octaves = F32_LOG(2.0f, (slots_per_minute / lag) / TEMPO_PRIOR_BPM) / TEMPO_PRIOR_OCTAVES;
+    f32 smoothed = 0.25f * (acf[lag - 1] + 2.0f * acf[lag] + acf[lag + 1]);
+    f32 score = smoothed * f32_fast_exp(-0.5f * SQUARE(octaves));
+    if (score > best_score)
+    {
+      best_score = score;
+      best_lag = lag;
+    }
+  }
+  if (best_lag == 0) return;
+
+  // NOTE(Ryan): Parabola through the peak and its neighbours for a lag between slots
+  f32 lag = (f32)best_lag;
+  f32 left = acf[best_lag - 1], centre = acf[best_lag], right = acf[best_lag + 1];
+  f32 curvature = left - 2.0f * centre + right;
+  if (curvature < 0.f) lag += CLAMP(-0.5f, 0.5f * (left - right) / curvature, 0.5f);
+
+  tempo->bpm = slots_per_minute / lag;
+  tempo->confidence = CLAMP(0.f, centre / acf[0], 1.f);
+}
+
+// NOTE(Ryan): Adds the onset strength of a frame ending at end_sample. 
+// Hops longer than a slot fill every slot they cover, shorter ones keep the largest.
+// Re-estimates at most every TEMPO_UPDATE_SECONDS of audio, and returns whether it did
+INTERNAL b32
+tempo_estimator_push(TempoEstimator *tempo, u64 end_sample, f32 strength, u32 sample_rate)
+{
+  if (sample_rate != tempo->sample_rate)
+  {
+    tempo->sample_rate = sample_rate;
+    tempo->num_slots = 0;
+    tempo->confidence = 0.f;
+  }
+
+  u64 slot = end_sample / TEMPO_ENVELOPE_HOP;
+  if (tempo->num_slots == 0 || slot > tempo->last_slot + TEMPO_ENVELOPE_SLOTS)
+  {
+    tempo->num_slots = 1;
+    tempo->last_slot = slot;
+    tempo->envelope[slot % TEMPO_ENVELOPE_SLOTS] = strength;
+  }
+  else if (slot == tempo->last_slot)
+  {
+    f32 *current = &tempo->envelope[slot % TEMPO_ENVELOPE_SLOTS];
+    *current = MAX(*current, strength);
+  }
+  else if (slot > tempo->last_slot)
+  {
+    for (u64 s = tempo->last_slot + 1; s <= slot; s += 1)
+    {
+      tempo->envelope[s % TEMPO_ENVELOPE_SLOTS] = strength;
+    }
+    tempo->num_slots += slot - tempo->last_slot;
+    tempo->last_slot = slot;
+  }
+
+  // NOTE(Ryan): Wait for at least two periods of the slowest tempo
+  u64 min_slots = (u64)(2.0f * 60.0f / TEMPO_MIN_BPM * sample_rate / TEMPO_ENVELOPE_HOP);
+  if (end_sample < tempo->next_update || tempo->num_slots < min_slots) return false;
+
+  tempo->next_update = end_sample + (u64)(TEMPO_UPDATE_SECONDS * sample_rate);
+  tempo_estimator_update(tempo);
+  return true;
+}
+
+// NOTE(Ryan): Krumhansl-Kessler key profiles, tonic first
+GLOBAL f32 g_key_profile_major[CHROMA_BINS] = {6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f};
+GLOBAL f32 g_key_profile_minor[CHROMA_BINS] = {6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f};
+
+INTERNAL String8
+key_name(u32 key)
+{
+  LOCAL_PERSIST char *names[KEY_COUNT] = {
+    "C major", "C# major", "D major", "D# major", "E major", "F major", 
+    "F# major", "G major", "G# major", "A major", "A# major", "B major",
+    "C minor", "C# minor", "D minor", "D# minor", "E minor", "F minor", 
+    "F# minor", "G minor", "G# minor", "A minor", "A# minor", "B minor",
+  };
+  if (key >= KEY_COUNT) return str8_lit("Unknown");
+  return str8_cstr(names[key]);
+}
+
+// NOTE(Ryan): Pearson correlation of a chroma against a profile rotated so its tonic is on pitch class tonic
+INTERNAL f32
+key_profile_correlation(f32 *chroma, f32 *profile, u32 tonic)
+{
+  f32 chroma_mean = 0.f, profile_mean = 0.f;
+  for (u32 c = 0; c < CHROMA_BINS; c += 1)
+  {
+    chroma_mean += chroma[c];
+    profile_mean += profile[c];
+  }
+  chroma_mean /= CHROMA_BINS;
+  profile_mean /= CHROMA_BINS;
+
+  f32 covariance = 0.f, chroma_variance = 0.f, profile_variance = 0.f;
+  for (u32 c = 0; c < CHROMA_BINS; c += 1)
+  {
+    f32 x = chroma[(c + tonic) % CHROMA_BINS] - chroma_mean;
+    f32 y = profile[c] - profile_mean;
+    covariance += x * y;
+    chroma_variance += x * x;
+    profile_variance += y * y;
+  }
+  if (chroma_variance <= 0.f) return 0.f;
+
+  return covariance / F32_SQRT(chroma_variance * profile_variance);
+}
+
+// NOTE(Ryan): Chroma is smoothed over roughly KEY_SMOOTHING_SECONDS, 
+// as a key is a property of a passage rather than a single frame
+INTERNAL void
+key_estimator_update(KeyEstimator *estimator, f32 *chroma, u32 hop, u32 sample_rate)
+{
+  f32 smoothing = 1.0f - f32_fast_exp(-(f32)hop / (KEY_SMOOTHING_SECONDS * sample_rate));
+  for (u32 c = 0; c < CHROMA_BINS; c += 1)
+  {
+    estimator->chroma[c] += (chroma[c] - estimator->chroma[c]) * smoothing;
+  }
+
+  f32 best = 0.f;
+  u32 best_key = estimator->key;
+  for (u32 tonic = 0; tonic < CHROMA_BINS; tonic += 1)
+  {
+    f32 major = key_profile_correlation(estimator->chroma, g_key_profile_major, tonic);
+    f32 minor = key_profile_correlation(estimator->chroma, g_key_profile_minor, tonic);
+    if (major > best) { best = major; best_key = tonic; }
+    if (minor > best) { best = minor; best_key = CHROMA_BINS + tonic; }
+  }
+
+  estimator->key = best_key;
+  estimator->confidence = best;
+}
+
+INTERNAL void
+pitch_tracker_init(MemArena *arena, PitchTracker *tracker)
+{
+  u32 n = YIN_FFT_SIZE;
+  tracker->samples = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, 2 * YIN_WINDOW);
+  tracker->rfft_plan = rfft_plan_create(arena, n);
+  tracker->fft_plan = fft_plan_create(arena, n);
+  tracker->padded = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, n);
+  tracker->window_re = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 2 + 1);
+  tracker->window_im = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 2 + 1);
+  tracker->re = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  tracker->im = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  tracker->difference = MEM_ARENA_PUSH_ARRAY(arena, f32, YIN_WINDOW + 1);
+  tracker->next_frame_end = 2 * YIN_WINDOW;
+}
+
+// NOTE(Ryan): r[lag] = sum over j < YIN_WINDOW of x[j] * x[j + lag], into re.
+// Cross-correlation is conj(A) * B in frequency, which is Hermitian as r is real.
+// So the inverse is the real part of a forward transform of its conjugate, over n
+INTERNAL void
+pitch_tracker_correlate(PitchTracker *tracker)
+{
+  u32 n = YIN_FFT_SIZE;
+  f32 *x = tracker->samples;
+
+  MEMORY_COPY(tracker->padded, x, YIN_WINDOW * sizeof(f32));
+  MEMORY_ZERO(tracker->padded + YIN_WINDOW, (n - YIN_WINDOW) * sizeof(f32));
+  rfft_execute(tracker->rfft_plan, tracker->padded, tracker->window_re, tracker->window_im);
+
+  MEMORY_COPY(tracker->padded, x, 2 * YIN_WINDOW * sizeof(f32));
+  rfft_execute(tracker->rfft_plan, tracker->padded, tracker->re, tracker->im);
+
+  for (u32 k = 0; k <= n / 2; k += 1)
+  {
+    f32 a_re = tracker->window_re[k], a_im = tracker->window_im[k];
+    f32 b_re = tracker->re[k], b_im = tracker->im[k];
+    f32 p_re = a_re * b_re + a_im * b_im;
+    f32 p_im = a_re * b_im - a_im * b_re;
+    tracker->re[k] = p_re;
+    tracker->im[k] = -p_im;
+    if (k > 0 && k < n / 2)
+    {
+      tracker->re[n - k] = p_re;
+      tracker->im[n - k] = p_im;
+    }
+  }
+  fft_execute(tracker->fft_plan, tracker->re, tracker->im);
+
+  f32 scale = 1.0f / n;
+  for (u32 lag = 0; lag <= YIN_WINDOW; lag += 1) tracker->re[lag] *= scale;
+}
+
+// NOTE(Ryan): YIN over the current samples:
+//   d(lag) = sum (x[j] - x[j + lag])^2 = e(0) + e(lag) - 2 r(lag), e being the energy of the window at lag
+//   d'(lag) = d(lag) * lag / sum of d over [1, lag]
+// The period is the first dip of d' below YIN_THRESHOLD, refined with a parabola through its neighbours
+INTERNAL PitchReading
+pitch_tracker_estimate(PitchTracker *tracker, u32 sample_rate)
+{
+  PitchReading reading = ZERO_STRUCT;
+  f32 *x = tracker->samples;
+
+  f32 energy = 0.f;
+  for (u32 j = 0; j < YIN_WINDOW; j += 1) energy += SQUARE(x[j]);
+  if (energy < YIN_SILENCE_POWER * YIN_WINDOW) return reading;
+
+  pitch_tracker_correlate(tracker);
+  f32 *r = tracker->re;
+
+  u32 min_lag = MAX((u32)(sample_rate / YIN_MAX_HZ), 2);
+  u32 max_lag = MIN((u32)(sample_rate / YIN_MIN_HZ), YIN_WINDOW - 1);
+  if (min_lag >= max_lag) return reading;
+
+  f32 *d = tracker->difference;
+  d[0] = 1.0f;
+  f32 shifted_energy = energy, running_sum = 0.f;
+  for (u32 lag = 1; lag <= max_lag + 1; lag += 1)
+  {
+    shifted_energy += SQUARE(x[lag - 1 + YIN_WINDOW]) - SQUARE(x[lag - 1]);
+    f32 difference = MAX(energy + shifted_energy - 2.0f * r[lag], 0.f);
+    running_sum += difference;
+    d[lag] = (running_sum > 0.f) ? difference * lag / running_sum : 1.0f;
+  }
+
+  u32 best = 0;
+  for (u32 lag = min_lag; lag <= max_lag; lag += 1)
+  {
+    if (d[lag] < YIN_THRESHOLD)
+    {
+      while (lag + 1 <= max_lag && d[lag + 1] < d[lag]) lag += 1;
+      best = lag;
+      break;
+    }
+  }
+  if (best == 0) return reading;
+
+  f32 period = (f32)best;
+  f32 left = d[best - 1], centre = d[best], right = d[best + 1];
+  f32 curvature = left - 2.0f * centre + right;
+  if (curvature > 0.f) period += CLAMP(-0.5f, 0.5f * (left - right) / curvature, 0.5f);
+
+  reading.hz = sample_rate / period;
+  reading.clarity = 1.0f - centre;
+  return reading;
+}
+
+// NOTE(Ryan): Runs once per YIN_HOP of new audio, on the latest hop boundary. 
+// Only the samples new since the last frame are read from the ring; the rest are shifted down.
+// Returns whether a new reading was made
+INTERNAL b32
+pitch_tracker_update(PitchTracker *tracker, f32 *ring, u32 ring_count, u64 num_written, u32 sample_rate)
+{
+  u32 length = 2 * YIN_WINDOW;
+  ASSERT(IS_POW2(ring_count) && ring_count >= 2 * length);
+
+  if (num_written < tracker->next_frame_end) return false;
+
+  u64 hops_behind = (num_written - tracker->next_frame_end) / YIN_HOP;
+  u64 frame_end = tracker->next_frame_end + hops_behind * YIN_HOP;
+  tracker->next_frame_end = frame_end + YIN_HOP;
+
+  u64 fresh = MIN(frame_end - tracker->frame_end, (u64)length);
+  u32 kept = length - (u32)fresh;
+  MEMORY_COPY(tracker->samples, tracker->samples + fresh, kept * sizeof(f32));
+  for (u32 i = kept; i < length; i += 1)
+  {
+    tracker->samples[i] = ring[(frame_end - length + i) & (ring_count - 1)];
+  }
+  tracker->frame_end = frame_end;
+
+  tracker->reading = pitch_tracker_estimate(tracker, sample_rate);
+  return true;
+}
+
+INTERNAL const char *
+pitch_class_name(u32 pitch_class)
+{
+  LOCAL_PERSIST const char *names[CHROMA_BINS] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+  return names[pitch_class % CHROMA_BINS];
+}
+
+// NOTE(Ryan): Scientific pitch octave of the semitone nearest hz, so A4 = 440Hz
+INTERNAL s32
+pitch_octave(f32 hz)
+{
+  s32 midi = F32_ROUND_S32(69.0f + 12.0f * F32_LOG(2.0f, hz / CHROMA_REFERENCE_HZ));
+  return midi / 12 - 1;
+}
+
+INTERNAL void
+pitch_publish(atomic_u64 *pitch, PitchReading reading)
+{
+  u64 packed = 0;
+  MEMORY_COPY(&packed, &reading, sizeof(packed));
+  atomic_u64_store(pitch, &packed);
+}
+
+INTERNAL PitchReading
+pitch_load(atomic_u64 *pitch)
+{
+  u64 packed = atomic_u64_load(pitch);
+  PitchReading reading = ZERO_STRUCT;
+  MEMORY_COPY(&reading, &packed, sizeof(reading));
+  return reading;
+}
+
+// NOTE(Ryan): Coefficients from ITU-R BS.1770, re-derived for sample rates other than 48kHz
+INTERNAL void
+k_weighting_init(KWeighting *filter, u32 sample_rate)
+{
+  MEMORY_ZERO_STRUCT(filter);
+
+  f64 shelf_hz = 1681.974450955533, shelf_gain_db = 3.999843853973347, shelf_q = 0.7071752369554196;
+  f64 k = F64_TAN(F64_PI * shelf_hz / sample_rate);
+  f64 vh = F64_POW(10.0, shelf_gain_db / 20.0);
+  f64 vb = F64_POW(vh, 0.4996667741545416);
+  f64 a0 = 1.0 + k / shelf_q + k * k;
+  f64 shelf[5] = {
+    (vh + vb * k / shelf_q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / shelf_q + k * k) / a0,
+    2.0 * (k * k - 1.0) / a0, (1.0 - k / shelf_q + k * k) / a0,
+  };
+
+  f64 pass_hz = 38.13547087602444, pass_q = 0.5003270373238773;
+  k = F64_TAN(F64_PI * pass_hz / sample_rate);
+  a0 = 1.0 + k / pass_q + k * k;
+  f64 pass[5] = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / pass_q + k * k) / a0};
+
+  for (u32 lane = 0; lane < K_WEIGHTING_LANES; lane += 1)
+  {
+    f64 *c = (lane < 2) ? shelf : pass;
+    filter->b0[lane] = (f32)c[0];
+    filter->b1[lane] = (f32)c[1];
+    filter->b2[lane] = (f32)c[2];
+    filter->a1[lane] = (f32)c[3];
+    filter->a2[lane] = (f32)c[4];
+  }
+}
+
+// NOTE(Ryan): Filters frames of interleaved stereo, returning the sum of squares of the weighted L and R
+INTERNAL f32
+k_weighting_process_scalar(KWeighting *filter, f32 *interleaved, u32 frames)
+{
+  f32 energy[K_WEIGHTING_LANES] = ZERO_STRUCT;
+  f32 *y = filter->y;
+  for (u32 i = 0; i < frames; i += 1)
+  {
+    f32 x[K_WEIGHTING_LANES] = {interleaved[2 * i], interleaved[2 * i + 1], y[0], y[1]};
+    for (u32 lane = 0; lane < K_WEIGHTING_LANES; lane += 1)
+    {
+      y[lane] = filter->b0[lane] * x[lane] + filter->z1[lane];
+      filter->z1[lane] = filter->b1[lane] * x[lane] + filter->z2[lane] - filter->a1[lane] * y[lane];
+      filter->z2[lane] = filter->b2[lane] * x[lane] - filter->a2[lane] * y[lane];
+      energy[lane] += y[lane] * y[lane];
+    }
+  }
+
+  return energy[2] + energy[3];
+}
+
+#if LANE4_ENABLED
+INTERNAL f32
+k_weighting_process_sse4(KWeighting *filter, f32 *interleaved, u32 frames)
+{
+  Lane4R32 b0 = lane4_r32_load(filter->b0), b1 = lane4_r32_load(filter->b1), b2 = lane4_r32_load(filter->b2);
+  Lane4R32 a1 = lane4_r32_load(filter->a1), a2 = lane4_r32_load(filter->a2);
+  Lane4R32 z1 = lane4_r32_load(filter->z1), z2 = lane4_r32_load(filter->z2), y = lane4_r32_load(filter->y);
+
+  Lane4R32 energy = lane4_r32(0.f);
+  for (u32 i = 0; i < frames; i += 1)
+  {
+    Lane4R32 x = lane4_r32_combine_low(lane4_r32_load_pair(interleaved + 2 * i), y);
+    y = lane_fmadd(b0, x, z1);
+    z1 = lane_fmadd(b1, x, z2) - a1 * y;
+    z2 = b2 * x - a2 * y;
+    energy = lane_fmadd(y, y, energy);
+  }
+
+  lane_store(filter->z1, z1);
+  lane_store(filter->z2, z2);
+  lane_store(filter->y, y);
+
+  f32 lanes[K_WEIGHTING_LANES] = ZERO_STRUCT;
+  lane_store(lanes, energy);
+  return lanes[2] + lanes[3];
+}
+#endif
+
+INTERNAL f32
+k_weighting_process(KWeighting *filter, f32 *interleaved, u32 frames)
+{
+#if LANE4_ENABLED
+  return k_weighting_process_sse4(filter, interleaved, frames);
+#else
+  return k_weighting_process_scalar(filter, interleaved, frames);
+#endif
+}
+
+INTERNAL f32
+loudness_from_energy(f32 energy)
+{
+  if (energy <= 0.f) return f32_neg_inf();
+  return -0.691f + 10.0f * F32_LOG(10.0f, energy);
+}
+
+INTERNAL void
+loudness_meter_reset(LoudnessMeter *meter, u32 sample_rate)
+{
+  meter->sample_rate = sample_rate;
+  k_weighting_init(&meter->filter, sample_rate);
+
+  meter->subblock_length = sample_rate / LOUDNESS_SUBBLOCKS_PER_SECOND;
+  meter->subblock_filled = 0;
+  meter->subblock_energy = 0.f;
+  meter->num_subblocks = 0;
+  MEMORY_ZERO(meter->histogram, sizeof(meter->histogram));
+  for (u32 i = 0; i < LOUDNESS_HISTOGRAM_BINS; i += 1)
+  {
+    f32 centre = LOUDNESS_ABSOLUTE_GATE + (i + 0.5f) * LOUDNESS_HISTOGRAM_STEP;
+    meter->bin_energy[i] = F32_POW(10.0f, (centre + 0.691f) / 10.0f);
+  }
+
+  f32 silent = f32_neg_inf();
+  atomic_f32_store(&meter->momentary, &silent);
+  atomic_f32_store(&meter->short_term, &silent);
+  atomic_f32_store(&meter->integrated, &silent);
+}
+
+// NOTE(Ryan): Mean square over the last count sub-blocks, which must all exist
+INTERNAL f32
+loudness_meter_window_energy(LoudnessMeter *meter, u32 count)
+{
+  f32 sum = 0.f;
+  for (u32 i = 1; i <= count; i += 1)
+  {
+    sum += meter->subblocks[(meter->num_subblocks - i) % LOUDNESS_SHORT_TERM_SUBBLOCKS];
+  }
+  return sum / count;
+}
+
+// NOTE(Ryan): Blocks under the absolute gate are never added. 
+// The relative gate sits 10 LU under the mean of those left, and the result is the mean of blocks above both
+INTERNAL f32
+loudness_meter_integrate(LoudnessMeter *meter)
+{
+  f64 total = 0.0;
+  u64 count = 0;
+  for (u32 i = 0; i < LOUDNESS_HISTOGRAM_BINS; i += 1)
+  {
+    total += (f64)meter->histogram[i] * meter->bin_energy[i];
+    count += meter->histogram[i];
+  }
+  if (count == 0) return f32_neg_inf();
+
+  f32 relative_gate = loudness_from_energy((f32)(total / count)) + LOUDNESS_RELATIVE_GATE;
+  s32 first = (s32)F32_CEIL((relative_gate - LOUDNESS_ABSOLUTE_GATE) * LOUDNESS_HISTOGRAM_BINS_PER_LU - 0.5f);
+  first = CLAMP(0, first, LOUDNESS_HISTOGRAM_BINS);
+
+  total = 0.0;
+  count = 0;
+  for (u32 i = (u32)first; i < LOUDNESS_HISTOGRAM_BINS; i += 1)
+  {
+    total += (f64)meter->histogram[i] * meter->bin_energy[i];
+    count += meter->histogram[i];
+  }
+  if (count == 0) return f32_neg_inf();
+
+  return loudness_from_energy((f32)(total / count));
+}
+
+INTERNAL void
+loudness_meter_finish_subblock(LoudnessMeter *meter)
+{
+  // NOTE(Ryan): Both channels are weighted 1, so their mean squares just add
+  meter->subblocks[meter->num_subblocks % LOUDNESS_SHORT_TERM_SUBBLOCKS] = meter->subblock_energy / meter->subblock_length;
+  meter->num_subblocks += 1;
+  meter->subblock_energy = 0.f;
+  meter->subblock_filled = 0;
+
+  if (meter->num_subblocks >= LOUDNESS_MOMENTARY_SUBBLOCKS)
+  {
+    f32 momentary = loudness_from_energy(loudness_meter_window_energy(meter, LOUDNESS_MOMENTARY_SUBBLOCKS));
+    atomic_f32_store(&meter->momentary, &momentary);
+
+    // NOTE(Ryan): The momentary window is also the 400ms gating block, stepped every 100ms for 75% overlap
+    if (momentary > LOUDNESS_ABSOLUTE_GATE)
+    {
+      u32 bin = (u32)((momentary - LOUDNESS_ABSOLUTE_GATE) * LOUDNESS_HISTOGRAM_BINS_PER_LU);
+      meter->histogram[MIN(bin, LOUDNESS_HISTOGRAM_BINS - 1)] += 1;
+    }
+    f32 integrated = loudness_meter_integrate(meter);
+    atomic_f32_store(&meter->integrated, &integrated);
+  }
+
+  if (meter->num_subblocks >= LOUDNESS_SHORT_TERM_SUBBLOCKS)
+  {
+    f32 short_term = loudness_from_energy(loudness_meter_window_energy(meter, LOUDNESS_SHORT_TERM_SUBBLOCKS));
+    atomic_f32_store(&meter->short_term, &short_term);
+  }
+}
+
+// NOTE(Ryan): Called on the audio thread with each block of interleaved stereo
+INTERNAL void
+loudness_meter_process(LoudnessMeter *meter, f32 *interleaved, u32 frames, u32 sample_rate)
+{
+  if (atomic_u32_exchange(&meter->reset_requested, 0) || sample_rate != meter->sample_rate)
+  {
+    loudness_meter_reset(meter, sample_rate);
+  }
+
+  while (frames > 0)
+  {
+    u32 count = MIN(frames, meter->subblock_length - meter->subblock_filled);
+    meter->subblock_energy += k_weighting_process(&meter->filter, interleaved, count);
+    meter->subblock_filled += count;
+    interleaved += 2 * count;
+    frames -= count;
+
+    if (meter->subblock_filled == meter->subblock_length) loudness_meter_finish_subblock(meter);
+  }
+}
+
+// NOTE(Ryan): Adds sum(L*R), sum(L^2), sum(R^2) of frames of interleaved stereo onto lr, ll and rr.
+// Over the interleaved data x, even lanes of x*x hold L^2 and odd lanes R^2, 
+// and even lanes of x times x shifted by one hold L*R, so nothing needs deinterleaving
+INTERNAL void
+stereo_products(f32 *interleaved, u32 frames, f32 *lr, f32 *ll, f32 *rr)
+{
+  u32 n = 2 * frames;
+  u32 i = 0;
+#if LANE_WIDTH > 1
+  LaneR32 lane_lr = lane_r32(0.f), lane_sq = lane_r32(0.f);
+  // IMPORTANT(Ryan): The shifted load reads one past the lane, so stop a lane early
+  for (; i + LANE_WIDTH < n; i += LANE_WIDTH)
+  {
+    LaneR32 x = lane_r32_load(interleaved + i);
+    LaneR32 shifted = lane_r32_load(interleaved + i + 1);
+    lane_lr = lane_fmadd(x, shifted, lane_lr);
+    lane_sq = lane_fmadd(x, x, lane_sq);
+  }
+  f32 lanes_lr[LANE_WIDTH], lanes_sq[LANE_WIDTH];
+  lane_store(lanes_lr, lane_lr);
+  lane_store(lanes_sq, lane_sq);
+  for (u32 k = 0; k < LANE_WIDTH; k += 2)
+  {
+    *lr += lanes_lr[k];
+    *ll += lanes_sq[k];
+    *rr += lanes_sq[k + 1];
+  }
+#endif
+  for (; i < n; i += 2)
+  {
+    f32 left = interleaved[i], right = interleaved[i + 1];
+    *lr += left * right;
+    *ll += left * left;
+    *rr += right * right;
+  }
+}
+
+INTERNAL f32
+stereo_correlation_from_sums(f32 lr, f32 ll, f32 rr, u32 frames)
+{
+  if (ll * rr <= SQUARE(CORRELATION_SILENCE_POWER * frames)) return 0.f;
+  return CLAMP(-1.0f, lr / F32_SQRT(ll * rr), 1.0f);
+}
+
+// NOTE(Ryan): Called on the audio thread with each block of interleaved stereo.
+// Republishes whenever a chunk completes
+INTERNAL void
+stereo_correlation_process(StereoCorrelation *meter, f32 *interleaved, u32 frames)
+{
+  while (frames > 0)
+  {
+    u32 count = MIN(frames, CORRELATION_CHUNK_FRAMES - meter->partial_frames);
+    stereo_products(interleaved, count, &meter->partial_lr, &meter->partial_ll, &meter->partial_rr);
+    meter->partial_frames += count;
+    interleaved += 2 * count;
+    frames -= count;
+
+    if (meter->partial_frames < CORRELATION_CHUNK_FRAMES) continue;
+
+    u32 slot = meter->num_chunks % CORRELATION_CHUNKS;
+    meter->chunk_lr[slot] = meter->partial_lr;
+    meter->chunk_ll[slot] = meter->partial_ll;
+    meter->chunk_rr[slot] = meter->partial_rr;
+    meter->num_chunks += 1;
+    meter->partial_lr = meter->partial_ll = meter->partial_rr = 0.f;
+    meter->partial_frames = 0;
+
+    u32 num_chunks = (u32)MIN(meter->num_chunks, CORRELATION_CHUNKS);
+    f32 lr = 0.f, ll = 0.f, rr = 0.f;
+    for (u32 c = 0; c < num_chunks; c += 1)
+    {
+      lr += meter->chunk_lr[c];
+      ll += meter->chunk_ll[c];
+      rr += meter->chunk_rr[c];
+    }
+    f32 correlation = stereo_correlation_from_sums(lr, ll, rr, num_chunks * CORRELATION_CHUNK_FRAMES);
+    atomic_f32_store(&meter->correlation, &correlation);
+  }
+}
+
+// NOTE(Ryan): num_bands frequencies spaced evenly in log frequency from lowest_hz to highest_hz
+INTERNAL void
+sliding_dft_config_log_spaced(SlidingDFTConfig *config, f32 lowest_hz, f32 highest_hz, u32 num_bands, u32 window)
+{
+  ASSERT(num_bands >= 2 && num_bands <= SLIDING_DFT_MAX_BANDS);
+  MEMORY_ZERO_STRUCT(config);
+  config->num_bands = num_bands;
+  config->window = window;
+  for (u32 b = 0; b < num_bands; b += 1)
+  {
+    config->hz[b] = lowest_hz * F32_POW(highest_hz / lowest_hz, (f32)b / (num_bands - 1));
+  }
+}
+
+// NOTE(Ryan): From any one thread other than the audio thread. 
+// Returns false if the audio thread hasn't taken up the previous request yet, so try again later
+INTERNAL b32
+sliding_dft_request(SlidingDFT *bank, SlidingDFTConfig *config)
+{
+  ASSERT(config->num_bands <= SLIDING_DFT_MAX_BANDS);
+  ASSERT(config->window > 0 && config->window <= SLIDING_DFT_MAX_WINDOW);
+
+  if (atomic_u32_load(&bank->request_pending)) return false;
+  bank->request = *config;
+  u32 pending = 1;
+  atomic_u32_store(&bank->request_pending, &pending);
+  return true;
+}
+
+// NOTE(Ryan): Starts from silence, as the state is only meaningful for the coefficients that built it
+INTERNAL void
+sliding_dft_configure(SlidingDFT *bank, SlidingDFTConfig *config, u32 sample_rate)
+{
+  bank->sample_rate = sample_rate;
+  bank->config = *config;
+  MEMORY_ZERO(bank->rotate_re, sizeof(bank->rotate_re));
+  MEMORY_ZERO(bank->rotate_im, sizeof(bank->rotate_im));
+  MEMORY_ZERO(bank->comb_re, sizeof(bank->comb_re));
+  MEMORY_ZERO(bank->comb_im, sizeof(bank->comb_im));
+  MEMORY_ZERO(bank->state_re, sizeof(bank->state_re));
+  MEMORY_ZERO(bank->state_im, sizeof(bank->state_im));
+  MEMORY_ZERO(bank->history, sizeof(bank->history));
+  bank->history_at = 0;
+
+  u32 window = config->window;
+  f64 taper = F64_POW(SLIDING_DFT_WINDOW_TAPER, 1.0 / window);
+  f64 window_sum = 0.0;
+  for (u32 d = 0; d < window; d += 1)
+  {
+    window_sum += F64_POW(taper, d) * (0.5 - 0.5 * F64_COS(F64_TAU * d / window));
+  }
+  bank->energy_scale = (f32)(2.0 / SQUARE(window_sum));
+
+  f64 bin = F64_TAU / window;
+  f64 offsets[3] = {0.0, bin, -bin};
+  for (u32 b = 0; b < config->num_bands; b += 1)
+  {
+    if (config->hz[b] >= 0.5f * sample_rate) continue;
+
+    f64 w = F64_TAU * config->hz[b] / sample_rate;
+    for (u32 k = 0; k < ARRAY_COUNT(offsets); k += 1)
+    {
+      u32 r = k * SLIDING_DFT_MAX_BANDS + b;
+      f64 wk = w + offsets[k];
+      bank->rotate_re[r] = (f32)(taper * F64_COS(wk));
+      bank->rotate_im[r] = (f32)(taper * F64_SIN(wk));
+      bank->comb_re[r] = (f32)(SLIDING_DFT_WINDOW_TAPER * F64_COS(wk * window));
+      bank->comb_im[r] = (f32)(SLIDING_DFT_WINDOW_TAPER * F64_SIN(wk * window));
+    }
+  }
+}
+
+// NOTE(Ryan): Runs count staged samples through resonators [first, first + LANE_WIDTH), 
+// keeping their state in registers for the whole run
+INTERNAL void
+sliding_dft_resonate(SlidingDFT *bank, u32 first, u32 count)
+{
+  LaneR32 rotate_re = lane_r32_load(bank->rotate_re + first);
+  LaneR32 rotate_im = lane_r32_load(bank->rotate_im + first);
+  LaneR32 comb_re = lane_r32_load(bank->comb_re + first);
+  LaneR32 comb_im = lane_r32_load(bank->comb_im + first);
+  LaneR32 state_re = lane_r32_load(bank->state_re + first);
+  LaneR32 state_im = lane_r32_load(bank->state_im + first);
+
+  for (u32 i = 0; i < count; i += 1)
+  {
+    LaneR32 x = lane_r32(bank->input[i]);
+    LaneR32 old = lane_r32(bank->delayed[i]);
+    LaneR32 next_re = lane_fmadd(rotate_re, state_re, x) - lane_fmadd(rotate_im, state_im, comb_re * old);
+    LaneR32 next_im = lane_fmadd(rotate_re, state_im, rotate_im * state_re) - comb_im * old;
+    state_re = next_re;
+    state_im = next_im;
+  }
+
+  lane_store(bank->state_re + first, state_re);
+  lane_store(bank->state_im + first, state_im);
+}
+
+// NOTE(Ryan): Called on the audio thread with each block of interleaved stereo, which is mixed to mono.
+// Publishes every band once per block
+INTERNAL void
+sliding_dft_process(SlidingDFT *bank, f32 *interleaved, u32 frames, u32 sample_rate)
+{
+  if (atomic_u32_load(&bank->request_pending))
+  {
+    SlidingDFTConfig config = bank->request;
+    u32 pending = 0;
+    atomic_u32_store(&bank->request_pending, &pending);
+    sliding_dft_configure(bank, &config, sample_rate);
+  }
+  if (bank->config.window == 0) return;
+  if (sample_rate != bank->sample_rate) sliding_dft_configure(bank, &bank->config, sample_rate);
+
+  u32 window = bank->config.window;
+  u32 num_bands = bank->config.num_bands;
+  while (frames > 0)
+  {
+    u32 count = MIN(frames, SLIDING_DFT_CHUNK);
+    u32 at = bank->history_at;
+    for (u32 i = 0; i < count; i += 1)
+    {
+      f32 x = 0.5f * (interleaved[2 * i] + interleaved[2 * i + 1]);
+      bank->input[i] = x;
+      bank->delayed[i] = bank->history[at];
+      bank->history[at] = x;
+      at = (at + 1 == window) ? 0 : at + 1;
+    }
+    bank->history_at = at;
+
+    for (u32 k = 0; k < 3; k += 1)
+    {
+      for (u32 b = 0; b < num_bands; b += LANE_WIDTH)
+      {
+        sliding_dft_resonate(bank, k * SLIDING_DFT_MAX_BANDS + b, count);
+      }
+    }
+
+    interleaved += 2 * count;
+    frames -= count;
+  }
+
+  f32 nyquist = 0.5f * bank->sample_rate;
+  for (u32 b = 0; b < num_bands; b += 1)
+  {
+    u32 above = SLIDING_DFT_MAX_BANDS + b, below = 2 * SLIDING_DFT_MAX_BANDS + b;
+    f32 re = 0.5f * bank->state_re[b] - 0.25f * (bank->state_re[above] + bank->state_re[below]);
+    f32 im = 0.5f * bank->state_im[b] - 0.25f * (bank->state_im[above] + bank->state_im[below]);
+    // NOTE(Ryan): Resonators for a band above Nyquist are left zeroed, so would just hold the input
+    f32 energy = (bank->config.hz[b] < nyquist) ? bank->energy_scale * (SQUARE(re) + SQUARE(im)) : 0.0f;
+    atomic_f32_store(&bank->energies[b], &energy);
+  }
+  atomic_u32_store(&bank->num_bands, &num_bands);
+  u64 num_blocks = atomic_u64_load(&bank->num_blocks) + 1;
+  atomic_u64_store(&bank->num_blocks, &num_blocks);
+}
+
+// NOTE(Ryan): {b0, b1, b2, a1, a2}, normalised so a0 = 1. 
+// Anything at or above Nyquist, where the formulas fold over, passes straight through
+INTERNAL void
+biquad_coefficients(BiquadParams *params, u32 sample_rate, f32 *coefficients)
+{
+  f64 b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+  if (params->type != BIQUAD_BYPASS && params->hz > 0.0f && params->hz < 0.5f * sample_rate)
+  {
+    f64 w = F64_TAU * params->hz / sample_rate;
+    f64 cosine = F64_COS(w), alpha = F64_SIN(w) / (2.0 * params->q);
+    f64 a = F64_POW(10.0, params->gain_db / 40.0), root = 2.0 * F64_SQRT(a) * alpha;
+    switch (params->type)
+    {
+      default: break;
+      case BIQUAD_HIGH_PASS:
+      {
+        b0 = b2 = 0.5 * (1.0 + cosine);
+        b1 = -(1.0 + cosine);
+        a0 = 1.0 + alpha; a1 = -2.0 * cosine; a2 = 1.0 - alpha;
+      } break;
+      case BIQUAD_LOW_PASS:
+      {
+        b0 = b2 = 0.5 * (1.0 - cosine);
+        b1 = 1.0 - cosine;
+        a0 = 1.0 + alpha; a1 = -2.0 * cosine; a2 = 1.0 - alpha;
+      } break;
+      case BIQUAD_PEAK:
+      {
+        b0 = 1.0 + alpha * a; b1 = -2.0 * cosine; b2 = 1.0 - alpha * a;
+        a0 = 1.0 + alpha / a; a1 = -2.0 * cosine; a2 = 1.0 - alpha / a;
+      } break;
+      case BIQUAD_LOW_SHELF:
+      {
+        b0 = a * ((a + 1.0) - (a - 1.0) * cosine + root);
+        b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cosine);
+        b2 = a * ((a + 1.0) - (a - 1.0) * cosine - root);
+        a0 = (a + 1.0) + (a - 1.0) * cosine + root;
+        a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cosine);
+        a2 = (a + 1.0) + (a - 1.0) * cosine - root;
+      } break;
+      case BIQUAD_HIGH_SHELF:
+      {
+        b0 = a * ((a + 1.0) + (a - 1.0) * cosine + root);
+        b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cosine);
+        b2 = a * ((a + 1.0) + (a - 1.0) * cosine - root);
+        a0 = (a + 1.0) - (a - 1.0) * cosine + root;
+        a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cosine);
+        a2 = (a + 1.0) - (a - 1.0) * cosine - root;
+      } break;
+    }
+  }
+
+  coefficients[0] = (f32)(b0 / a0);
+  coefficients[1] = (f32)(b1 / a0);
+  coefficients[2] = (f32)(b2 / a0);
+  coefficients[3] = (f32)(a1 / a0);
+  coefficients[4] = (f32)(a2 / a0);
+}
+
+INTERNAL void
+equaliser_config_default(EqualiserConfig *config)
+{
+  MEMORY_ZERO_STRUCT(config);
+
+  // NOTE(Ryan): Q of each half of a 4th order Butterworth
+  f32 butterworth_q[2] = {0.5411961f, 1.3065630f};
+  for (u32 s = 0; s < EQ_FIRST_USER_STAGE; s += 1)
+  {
+    BiquadParams *stage = &config->stages[s];
+    if (s < ARRAY_COUNT(butterworth_q))
+    {
+      stage->type = BIQUAD_HIGH_PASS;
+      stage->hz = EQ_RUMBLE_HZ;
+      stage->q = butterworth_q[s];
+    }
+  }
+  for (u32 b = 0; b < EQ_USER_BANDS; b += 1)
+  {
+    BiquadParams *stage = &config->stages[EQ_FIRST_USER_STAGE + b];
+    stage->type = BIQUAD_PEAK;
+    stage->hz = EQ_LOWEST_BAND_HZ * (f32)(1u << b);
+    stage->q = EQ_BAND_Q;
+    stage->gain_db = 0.0f;
+  }
+}
+
+// NOTE(Ryan): Where stage's left channel sits in the lanes, with the right one after it
+INTERNAL u32
+equaliser_lane(u32 stage)
+{
+  u32 stages_per_group = EQ_GROUP_WIDTH / 2;
+  u32 group = stage / stages_per_group, from_top = stage % stages_per_group;
+  return group * EQ_GROUP_WIDTH + EQ_GROUP_WIDTH - 2 - 2 * from_top;
+}
+
+// NOTE(Ryan): From any one thread other than the audio thread. 
+// Returns false if the audio thread hasn't taken up the previous request yet, so try again later
+INTERNAL b32
+equaliser_request(Equaliser *eq, EqualiserConfig *config)
+{
+  if (atomic_u32_load(&eq->request_pending)) return false;
+  eq->request = *config;
+  u32 pending = 1;
+  atomic_u32_store(&eq->request_pending, &pending);
+  return true;
+}
+
+// NOTE(Ryan): Filter state is kept, so moving a band doesn't click
+INTERNAL void
+equaliser_configure(Equaliser *eq, EqualiserConfig *config, u32 sample_rate)
+{
+  eq->sample_rate = sample_rate;
+  eq->config = *config;
+  for (u32 s = 0; s < EQ_STAGES; s += 1)
+  {
+    f32 coefficients[5] = ZERO_STRUCT;
+    biquad_coefficients(&config->stages[s], sample_rate, coefficients);
+    u32 lane = equaliser_lane(s);
+    for (u32 channel = 0; channel < 2; channel += 1)
+    {
+      eq->b0[lane + channel] = coefficients[0];
+      eq->b1[lane + channel] = coefficients[1];
+      eq->b2[lane + channel] = coefficients[2];
+      eq->a1[lane + channel] = coefficients[3];
+      eq->a2[lane + channel] = coefficients[4];
+    }
+  }
+}
+
+// NOTE(Ryan): Same pipelined cascade one lane at a time, stages last to first 
+// so each still sees the output its predecessor had on the previous frame
+INTERNAL void
+equaliser_run_scalar(Equaliser *eq, f32 *interleaved, u32 frames)
+{
+  for (u32 i = 0; i < frames; i += 1)
+  {
+    for (u32 s = EQ_STAGES - 1; s != U32_MAX; s -= 1)
+    {
+      u32 lane = equaliser_lane(s);
+      for (u32 channel = 0; channel < 2; channel += 1)
+      {
+        u32 l = lane + channel;
+        f32 x = (s == 0) ? interleaved[2 * i + channel] : eq->y[equaliser_lane(s - 1) + channel];
+        eq->y[l] = eq->b0[l] * x + eq->z1[l];
+        eq->z1[l] = eq->b1[l] * x + eq->z2[l] - eq->a1[l] * eq->y[l];
+        eq->z2[l] = eq->b2[l] * x - eq->a2[l] * eq->y[l];
+      }
+    }
+    u32 last = equaliser_lane(EQ_STAGES - 1);
+    interleaved[2 * i] = eq->y[last];
+    interleaved[2 * i + 1] = eq->y[last + 1];
+  }
+}
+
+#if LANE_WIDTH > 1
+#define EQ_GROUPS (EQ_LANES / LANE_WIDTH)
+// NOTE(Ryan): Groups are also updated last to first, so a group's input is still the previous frame's 
+// output of the group before. The frame going in rides down in the top pair of the first group
+INTERNAL void
+equaliser_run_lanes(Equaliser *eq, f32 *interleaved, u32 frames)
+{
+  LaneR32 b0[EQ_GROUPS], b1[EQ_GROUPS], b2[EQ_GROUPS], a1[EQ_GROUPS], a2[EQ_GROUPS];
+  LaneR32 z1[EQ_GROUPS], z2[EQ_GROUPS], y[EQ_GROUPS];
+  for (u32 g = 0; g < EQ_GROUPS; g += 1)
+  {
+    u32 at = g * LANE_WIDTH;
+    b0[g] = lane_r32_load(eq->b0 + at); b1[g] = lane_r32_load(eq->b1 + at); b2[g] = lane_r32_load(eq->b2 + at);
+    a1[g] = lane_r32_load(eq->a1 + at); a2[g] = lane_r32_load(eq->a2 + at);
+    z1[g] = lane_r32_load(eq->z1 + at); z2[g] = lane_r32_load(eq->z2 + at); y[g] = lane_r32_load(eq->y + at);
+  }
+
+  for (u32 i = 0; i < frames; i += 1)
+  {
+    LaneR32 frame = lane_r32_load_pair(interleaved + 2 * i);
+    for (u32 g = EQ_GROUPS - 1; g != U32_MAX; g -= 1)
+    {
+      LaneR32 x = lane_shift_down_pair(y[g], (g == 0) ? frame : y[g - 1]);
+      y[g] = lane_fmadd(b0[g], x, z1[g]);
+      z1[g] = lane_fmadd(b1[g], x, z2[g]) - a1[g] * y[g];
+      z2[g] = b2[g] * x - a2[g] * y[g];
+    }
+    lane_store_pair(interleaved + 2 * i, y[EQ_GROUPS - 1]);
+  }
+
+  for (u32 g = 0; g < EQ_GROUPS; g += 1)
+  {
+    u32 at = g * LANE_WIDTH;
+    lane_store(eq->z1 + at, z1[g]);
+    lane_store(eq->z2 + at, z2[g]);
+    lane_store(eq->y + at, y[g]);
+  }
+}
+#endif
+
+// NOTE(Ryan): Called on the audio thread with each block of interleaved stereo, which is filtered in place
+INTERNAL void
+equaliser_process(Equaliser *eq, f32 *interleaved, u32 frames, u32 sample_rate)
+{
+  if (atomic_u32_load(&eq->request_pending))
+  {
+    EqualiserConfig config = eq->request;
+    u32 pending = 0;
+    atomic_u32_store(&eq->request_pending, &pending);
+    equaliser_configure(eq, &config, sample_rate);
+  }
+  else if (sample_rate != eq->sample_rate) 
+  {
+    equaliser_configure(eq, &eq->config, sample_rate);
+  }
+
+  u32 float_mode = float_mode_flush_denormals();
+#if LANE_WIDTH > 1
+  equaliser_run_lanes(eq, interleaved, frames);
+#else
+  equaliser_run_scalar(eq, interleaved, frames);
+#endif
+  float_mode_restore(float_mode);
+}
+
+INTERNAL void
+convolver_init(MemArena *arena, Convolver *conv)
+{
+  conv->plan = rfft_plan_create(arena, CONVOLVER_FFT_SIZE);
+  u32 spectrum_floats = CONVOLVER_SPECTRA * CONVOLVER_STRIDE;
+  for (u32 set = 0; set < 2; set += 1)
+  {
+    conv->filter_re[set] = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, spectrum_floats);
+    conv->filter_im[set] = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, spectrum_floats);
+  }
+  conv->history_re = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, spectrum_floats);
+  conv->history_im = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, spectrum_floats);
+  conv->padded = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, CONVOLVER_FFT_SIZE);
+}
+
+// NOTE(Ryan): From any one thread other than the audio thread, which then calls convolver_build until it's done.
+// right can be NULL to use left for both, and 0 taps turns convolution off. Anything past CONVOLVER_MAX_TAPS is dropped.
+// Starts over if the last IR is still being built, so left and right must be left alone until it's done.
+// Returns false if the audio thread hasn't taken up the previous IR yet, so try again later
+INTERNAL b32
+convolver_request(Convolver *conv, f32 *left, f32 *right, u32 taps)
+{
+  if (atomic_u32_load(&conv->request_pending)) return false;
+
+  conv->build_ir[0] = left;
+  conv->build_ir[1] = (right != NULL) ? right : left;
+  conv->build_taps = MIN(taps, CONVOLVER_MAX_TAPS);
+  conv->build_cursor = 0;
+  conv->building = true;
+  return true;
+}
+
+// NOTE(Ryan): Transforms up to max_partitions more partitions of the requested IR into the set 
+// the audio thread isn't reading, and only hands it over once it's whole. 
+// Returns true once there's nothing left to build
+INTERNAL b32
+convolver_build(Convolver *conv, u32 max_partitions)
+{
+  if (!conv->building) return true;
+
+  u32 set = atomic_u32_load(&conv->active_set) ^ 1;
+  u32 taps = conv->build_taps;
+  u32 num_partitions = (taps + CONVOLVER_BLOCK - 1) / CONVOLVER_BLOCK;
+  u32 end = MIN(conv->build_cursor + max_partitions, num_partitions);
+  for (u32 p = conv->build_cursor; p < end; p += 1)
+  {
+    u32 start = p * CONVOLVER_BLOCK, count = MIN(CONVOLVER_BLOCK, taps - start);
+    for (u32 channel = 0; channel < 2; channel += 1)
+    {
+      MEMORY_COPY(conv->padded, conv->build_ir[channel] + start, count * sizeof(f32));
+      MEMORY_ZERO(conv->padded + count, (CONVOLVER_FFT_SIZE - count) * sizeof(f32));
+      u32 at = (channel * CONVOLVER_MAX_PARTITIONS + p) * CONVOLVER_STRIDE;
+      rfft_execute(conv->plan, conv->padded, conv->filter_re[set] + at, conv->filter_im[set] + at);
+    }
+  }
+  conv->build_cursor = end;
+  if (end < num_partitions) return false;
+
+  conv->num_partitions[set] = num_partitions;
+  conv->building = false;
+  u32 pending = 1;
+  atomic_u32_store(&conv->request_pending, &pending);
+  return true;
+}
+
+// NOTE(Ryan): sum += x * h over every bin, complex
+INTERNAL void
+convolver_accumulate(f32 *sum_re, f32 *sum_im, f32 *x_re, f32 *x_im, f32 *h_re, f32 *h_im)
+{
+  for (u32 k = 0; k < CONVOLVER_STRIDE; k += LANE_WIDTH)
+  {
+    LaneR32 xr = lane_r32_load(x_re + k), xi = lane_r32_load(x_im + k);
+    LaneR32 hr = lane_r32_load(h_re + k), hi = lane_r32_load(h_im + k);
+    LaneR32 sr = lane_r32_load(sum_re + k), si = lane_r32_load(sum_im + k);
+    sr = lane_fmadd(xr, hr, sr) - xi * hi;
+    si = lane_fmadd(xr, hi, si) + xi * hr;
+    lane_store(sum_re + k, sr);
+    lane_store(sum_im + k, si);
+  }
+}
+
+INTERNAL void
+convolver_run_block(Convolver *conv, u32 set)
+{
+  u32 num_partitions = MIN(conv->num_partitions[set], conv->num_blocks + 1);
+  for (u32 channel = 0; channel < 2; channel += 1)
+  {
+    f32 *input = conv->input[channel];
+    u32 latest = (conv->history_at * 2 + channel) * CONVOLVER_STRIDE;
+    rfft_execute(conv->plan, input, conv->history_re + latest, conv->history_im + latest);
+    MEMORY_COPY(input, input + CONVOLVER_BLOCK, CONVOLVER_BLOCK * sizeof(f32));
+
+    MEMORY_ZERO(conv->sum_re, sizeof(conv->sum_re));
+    MEMORY_ZERO(conv->sum_im, sizeof(conv->sum_im));
+    f32 *filter_re = conv->filter_re[set] + channel * CONVOLVER_MAX_PARTITIONS * CONVOLVER_STRIDE;
+    f32 *filter_im = conv->filter_im[set] + channel * CONVOLVER_MAX_PARTITIONS * CONVOLVER_STRIDE;
+    u32 slot = conv->history_at;
+    for (u32 p = 0; p < num_partitions; p += 1)
+    {
+      u32 at = (slot * 2 + channel) * CONVOLVER_STRIDE;
+      convolver_accumulate(conv->sum_re, conv->sum_im, conv->history_re + at, conv->history_im + at, 
+                           filter_re + p * CONVOLVER_STRIDE, filter_im + p * CONVOLVER_STRIDE);
+      slot = (slot == 0) ? CONVOLVER_MAX_PARTITIONS - 1 : slot - 1;
+    }
+
+    // NOTE(Ryan): The first half has wrapped around, the second is the linear convolution
+    rfft_inverse_execute(conv->plan, conv->sum_re, conv->sum_im, conv->time);
+    MEMORY_COPY(conv->output[channel], conv->time + CONVOLVER_BLOCK, CONVOLVER_BLOCK * sizeof(f32));
+  }
+
+  conv->history_at = (conv->history_at + 1) % CONVOLVER_MAX_PARTITIONS;
+  conv->num_blocks = MIN(conv->num_blocks + 1, CONVOLVER_MAX_PARTITIONS);
+}
+
+// NOTE(Ryan): Called on the audio thread with each block of interleaved stereo, which is convolved in place
+INTERNAL void
+convolver_process(Convolver *conv, f32 *interleaved, u32 frames)
+{
+  u32 set = atomic_u32_load(&conv->active_set);
+  if (atomic_u32_load(&conv->request_pending))
+  {
+    // NOTE(Ryan): Coming on from off, the input and output blocks are started afresh 
+    // rather than playing out whatever was left in them. Changing IR keeps the history, as it's still valid
+    if (conv->num_partitions[set] == 0)
+    {
+      MEMORY_ZERO(conv->input, sizeof(conv->input));
+      MEMORY_ZERO(conv->output, sizeof(conv->output));
+      conv->fill = 0;
+      conv->num_blocks = 0;
+    }
+    set ^= 1;
+    atomic_u32_store(&conv->active_set, &set);
+    u32 pending = 0;
+    atomic_u32_store(&conv->request_pending, &pending);
+  }
+  if (conv->num_partitions[set] == 0) return;
+
+  for (u32 i = 0; i < frames; i += 1)
+  {
+    for (u32 channel = 0; channel < 2; channel += 1)
+    {
+      conv->input[channel][CONVOLVER_BLOCK + conv->fill] = interleaved[2 * i + channel];
+      interleaved[2 * i + channel] = conv->output[channel][conv->fill];
+    }
+    conv->fill += 1;
+    if (conv->fill == CONVOLVER_BLOCK)
+    {
+      convolver_run_block(conv, set);
+      conv->fill = 0;
+    }
+  }
+}
+
+// NOTE(Ryan): The direct sound, then after a predelay exponentially decaying noise, 
+// different on each side so the tail comes out wide
+INTERNAL void
+reverb_room_impulse(f32 *left, f32 *right, u32 taps, u32 sample_rate, u32 seed)
+{
+  u32 predelay = (u32)(REVERB_PREDELAY_SECONDS * sample_rate);
+  // NOTE(Ryan): -60dB over RT60 is a factor of 1000 in amplitude
+  f32 decay = F32_POW(0.001f, 1.0f / (REVERB_RT60_SECONDS * sample_rate));
+  f32 *channels[2] = {left, right};
+  for (u32 channel = 0; channel < 2; channel += 1)
+  {
+    f32 *ir = channels[channel];
+    f64 energy = 0.0;
+    f32 envelope = 1.0f;
+    for (u32 t = 0; t < taps; t += 1)
+    {
+      ir[t] = 0.0f;
+      if (t >= predelay)
+      {
+        ir[t] = envelope * f32_rand_bilateral(&seed);
+        envelope *= decay;
+        energy += SQUARE(ir[t]);
+      }
+    }
+    f32 scale = (energy > 0.0) ? (f32)F64_SQRT(REVERB_WET_ENERGY / energy) : 0.0f;
+    for (u32 t = predelay; t < taps; t += 1) ir[t] *= scale;
+    if (taps > 0) ir[0] = 1.0f;
+  }
+}
+
+// NOTE(Ryan): Deck 0 fully up, with nothing on it yet
+INTERNAL void
+crossfader_init(Crossfader *x)
+{
+  MEMORY_ZERO_STRUCT(x);
+  x->position = 1.0f;
+}
+
+// NOTE(Ryan): From any one thread other than the audio thread. 0 frames cuts straight over.
+// Returns false if the audio thread hasn't taken up the previous request yet, so try again later
+INTERNAL b32
+crossfader_request(Crossfader *x, u32 deck, u32 frames)
+{
+  if (atomic_u32_load(&x->request_pending)) return false;
+  x->request_deck = deck;
+  x->request_frames = frames;
+  u32 pending = 1;
+  atomic_u32_store(&x->request_pending, &pending);
+  return true;
+}
+
+// NOTE(Ryan): Called from deck's stream processor on the audio thread, any number of times per device callback. 
+// The stream is left silent, as it's the mix that gets played
+INTERNAL void
+crossfader_stage(Crossfader *x, u32 deck, f32 *interleaved, u32 frames)
+{
+  u32 count = MIN(frames, CROSSFADE_MAX_FRAMES - x->num_staged[deck]);
+  MEMORY_COPY(x->staged[deck] + 2 * x->num_staged[deck], interleaved, 2 * count * sizeof(f32));
+  x->num_staged[deck] += count;
+  MEMORY_ZERO(interleaved, 2 * frames * sizeof(f32));
+}
+
+// NOTE(Ryan): Called once per device callback on the audio thread, after every deck has been staged. 
+// Gains are eased linearly across the callback between their exact values at either end, 
+// which is well under 1e-4 off the curve for any fade longer than a few callbacks.
+// Returns how many frames the decks actually delivered, so 0 means nothing is playing
+INTERNAL u32
+crossfader_mix(Crossfader *x, f32 *out, u32 frames)
+{
+  if (atomic_u32_load(&x->request_pending))
+  {
+    if (x->request_deck != x->incoming)
+    {
+      x->incoming = x->request_deck;
+      x->position = 1.0f - x->position;
+    }
+    if (x->request_frames == 0) x->position = 1.0f;
+    x->step = (x->request_frames > 0) ? 1.0f / x->request_frames : 0.0f;
+    u32 fading = (x->position < 1.0f);
+    atomic_u32_store(&x->fading, &fading);
+    u32 pending = 0;
+    atomic_u32_store(&x->request_pending, &pending);
+  }
+
+  u32 delivered = MAX(x->num_staged[0], x->num_staged[1]);
+  u32 mixed = MIN(frames, CROSSFADE_MAX_FRAMES);
+  f32 *from = x->staged[x->incoming ^ 1], *to = x->staged[x->incoming];
+  for (u32 deck = 0; deck < 2; deck += 1)
+  {
+    if (x->num_staged[deck] < mixed)
+    {
+      MEMORY_ZERO(x->staged[deck] + 2 * x->num_staged[deck], 2 * (mixed - x->num_staged[deck]) * sizeof(f32));
+    }
+    x->num_staged[deck] = 0;
+  }
+
+  // NOTE(Ryan): A fade ending part way through holds its end gains from there on
+  f32 start = x->position, end = MIN(1.0f, start + x->step * mixed);
+  f32 ramp = (f32)mixed;
+  if (x->step > 0.0f) ramp = MIN(ramp, (1.0f - start) / x->step);
+  f32 from_gain = F32_COS(start * F32_TAU * 0.25f), to_gain = F32_SIN(start * F32_TAU * 0.25f);
+  f32 from_step = 0.0f, to_step = 0.0f;
+  if (ramp > 0.0f)
+  {
+    from_step = (F32_COS(end * F32_TAU * 0.25f) - from_gain) / ramp;
+    to_step = (F32_SIN(end * F32_TAU * 0.25f) - to_gain) / ramp;
+  }
+
+  // NOTE(Ryan): Lanes hold left/right pairs, so each frame's offset appears twice
+  f32 frame_offsets[8] = {0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f};
+  LaneR32 offsets = lane_r32_load(frame_offsets);
+  u32 lane_end = (2 * mixed) & ~(u32)(LANE_WIDTH - 1);
+  for (u32 i = 0; i < lane_end; i += LANE_WIDTH)
+  {
+    LaneR32 frame = lane_min(lane_r32((f32)(i / 2)) + offsets, lane_r32(ramp));
+    LaneR32 from_lane = lane_fmadd(frame, lane_r32(from_step), lane_r32(from_gain));
+    LaneR32 to_lane = lane_fmadd(frame, lane_r32(to_step), lane_r32(to_gain));
+    LaneR32 mix = lane_fmadd(to_lane, lane_r32_load(to + i), from_lane * lane_r32_load(from + i));
+    lane_store(out + i, mix);
+  }
+  for (u32 i = lane_end; i < 2 * mixed; i += 1)
+  {
+    f32 frame = MIN((f32)(i / 2), ramp);
+    out[i] = (to_gain + frame * to_step) * to[i] + (from_gain + frame * from_step) * from[i];
+  }
+  if (frames > mixed) MEMORY_ZERO(out + 2 * mixed, 2 * (frames - mixed) * sizeof(f32));
+
+  x->position = end;
+  if (start < 1.0f && end >= 1.0f)
+  {
+    u32 fading = 0;
+    atomic_u32_store(&x->fading, &fading);
+  }
+
+  return MIN(delivered, frames);
+}
+
+// NOTE(Ryan): Unwraps the latest num_frames of an interleaved stereo ring into dst, 
+// which must hold 2 * num_frames + 2 so there's a zeroed pad either side of the samples
+INTERNAL f32 *
+stereo_ring_unwrap(f32 *ring, u32 ring_frames, u64 num_written, u32 num_frames, f32 *dst)
+{
+  ASSERT(num_frames <= ring_frames);
+  f32 *samples = dst + 1;
+  u32 start = (u32)((num_written - num_frames) % ring_frames);
+  u32 first = MIN(num_frames, ring_frames - start);
+  MEMORY_COPY(samples, ring + 2 * start, 2 * first * sizeof(f32));
+  MEMORY_COPY(samples + 2 * first, ring, 2 * (num_frames - first) * sizeof(f32));
+  dst[0] = samples[2 * num_frames] = 0.f;
+  return samples;
+}
+
+// NOTE(Ryan): x = centre_x + (R - L) * radius / 2, y = centre_y - (L + R) * radius / 2, 
+// so full scale stays inside the radius and y grows downwards as it does on screen.
+// Over the interleaved data, even lanes take R from the load one ahead and odd lanes L from the one behind, 
+// which is why the samples need a pad either side
+INTERNAL void
+goniometer_points(f32 *samples, u32 num_frames, f32 centre_x, f32 centre_y, f32 radius, f32 *xy)
+{
+  f32 k = 0.5f * radius;
+  u32 n = 2 * num_frames;
+  u32 i = 0;
+#if LANE_WIDTH > 1
+  f32 cur_weights[LANE_WIDTH], next_weights[LANE_WIDTH], prev_weights[LANE_WIDTH], offsets[LANE_WIDTH];
+  for (u32 lane = 0; lane < LANE_WIDTH; lane += 2)
+  {
+    cur_weights[lane] = -k;
+    next_weights[lane] = k;
+    prev_weights[lane] = 0.f;
+    offsets[lane] = centre_x;
+
+    cur_weights[lane + 1] = -k;
+    next_weights[lane + 1] = 0.f;
+    prev_weights[lane + 1] = -k;
+    offsets[lane + 1] = centre_y;
+  }
+  LaneR32 cur_w = lane_r32_load(cur_weights), next_w = lane_r32_load(next_weights);
+  LaneR32 prev_w = lane_r32_load(prev_weights), offset = lane_r32_load(offsets);
+
+  for (; i + LANE_WIDTH <= n; i += LANE_WIDTH)
+  {
+    LaneR32 cur = lane_r32_load(samples + i);
+    LaneR32 next = lane_r32_load(samples + i + 1);
+    LaneR32 prev = lane_r32_load(samples + i - 1);
+    LaneR32 result = lane_fmadd(cur, cur_w, offset);
+    result = lane_fmadd(next, next_w, result);
+    result = lane_fmadd(prev, prev_w, result);
+    lane_store(xy + i, result);
+  }
+#endif
+  for (; i < n; i += 2)
+  {
+    f32 left = samples[i], right = samples[i + 1];
+    xy[i] = centre_x + (right - left) * k;
+    xy[i + 1] = centre_y - (left + right) * k;
+  }
+}
+
+// NOTE(Ryan): Bands needed by the largest FFT or filterbank, to size anything that holds a frame.
+// Filter counts only depend on the sample rate up to FILTERBANK_HIGHEST_HZ, so this covers any rate
+INTERNAL u32
+dsp_max_bands(f32 bin_growth)
+{
+  u32 max_bands = log_bin_map_count_bands(FFT_SIZE_MAX / 2, bin_growth);
+  for (u32 scale = SPECTRUM_SCALE_LOG_BANDS + 1; scale < SPECTRUM_SCALE_COUNT; scale += 1)
+  {
+    max_bands = MAX(max_bands, filterbank_count((SPECTRUM_SCALE)scale, FILTERBANK_HIGHEST_HZ));
+  }
+  return max_bands;
+}
+
+INTERNAL u32
+fft_size_index(u32 fft_size)
+{
+  ASSERT(IS_POW2(fft_size) && fft_size >= FFT_SIZE_MIN && fft_size <= FFT_SIZE_MAX);
+  return u32_count_trailing_zeroes(fft_size) - u32_count_trailing_zeroes(FFT_SIZE_MIN);
+}
+
+// NOTE(Ryan): arena is given over to the worker, as plans for new sizes are built on its thread
+INTERNAL void
+dsp_worker_init(MemArena *arena, DSPWorker *worker, u32 fft_size, f32 bin_growth, u32 sample_rate,
+                f32 *ring, u32 ring_count, atomic_u64 *ring_num_written)
+{
+  ASSERT(ring_count >= 2 * FFT_SIZE_MAX);
+
+  worker->arena = arena;
+  worker->bin_growth = bin_growth;
+  worker->ring = ring;
+  worker->ring_count = ring_count;
+  worker->ring_num_written = ring_num_written;
+  atomic_u32_store(&worker->requested_fft_size, &fft_size);
+  worker->sample_rate = sample_rate;
+  u32 refine = PEAK_REFINE_QUADRATIC;
+  atomic_u32_store(&worker->active_refine, &refine);
+  spectrum_exchange_init(arena, &worker->exchange, dsp_max_bands(bin_growth));
+  onset_detector_init(arena, &worker->onset_detector, dsp_max_bands(bin_growth));
+  tempo_estimator_init(arena, &worker->tempo);
+  pitch_tracker_init(arena, &worker->pitch_tracker);
+}
+
+INTERNAL void *
+dsp_worker_thread(void *params)
+{
+  DSPWorker *worker = (DSPWorker *)params;
+
+  while (atomic_u32_load(&worker->running))
+  {
+    worker->fft_size = atomic_u32_load(&worker->requested_fft_size);
+    SPECTRUM_SCALE scale = (SPECTRUM_SCALE)atomic_u32_load(&worker->active_scale);
+    u32 sample_rate = worker->sample_rate;
+
+    SpectrumAnalyser **slot = &worker->analysers[fft_size_index(worker->fft_size)][scale];
+    if (*slot == NULL)
+    {
+      memory_index analyser_pos = worker->arena->pos;
+      *slot = spectrum_analyser_create(worker->arena, worker->fft_size, worker->bin_growth, scale, sample_rate);
+      // IMPORTANT(Ryan): An arena that has run out doesn't move, so this catches it being sized too small
+      ASSERT(worker->arena->pos > analyser_pos);
+    }
+    SpectrumAnalyser *analyser = *slot;
+
+    u64 num_written = atomic_u64_load(worker->ring_num_written);
+    WINDOW window = (WINDOW)atomic_u32_load(&worker->active_window);
+    PEAK_REFINE refine = (PEAK_REFINE)atomic_u32_load(&worker->active_refine);
+    SpectrumFrame *frame = spectrum_exchange_back(&worker->exchange);
+
+    b32 did_work = false;
+    if (spectrum_analyser_update(analyser, worker->ring, worker->ring_count, num_written, window, frame, refine))
+    {
+      OnsetDetector *detector = &worker->onset_detector;
+      TempoEstimator *tempo = &worker->tempo;
+      u64 onset = 0;
+      b32 is_onset = onset_detector_update(detector, frame, sample_rate, &onset);
+
+      // NOTE(Ryan): A confident tempo is steadier than gaps between individual onsets
+      if (tempo_estimator_push(tempo, frame->end_sample, detector->strength, sample_rate) && 
+          tempo->confidence >= TEMPO_CONFIDENT)
+      {
+        detector->beat_period = 60.0f * sample_rate / tempo->bpm;
+      }
+      if (is_onset) onset_track_publish(&worker->onsets, detector, onset);
+
+      frame->tempo_bpm = tempo->bpm;
+      frame->tempo_confidence = tempo->confidence;
+
+      key_estimator_update(&worker->key, frame->chroma, frame->hop, sample_rate);
+      frame->key = worker->key.key;
+      frame->key_confidence = worker->key.confidence;
+      spectrum_exchange_publish(&worker->exchange);
+      did_work = true;
+    }
+
+    // NOTE(Ryan): Pitch runs on its own short hop, independent of the FFT size
+    if (pitch_tracker_update(&worker->pitch_tracker, worker->ring, worker->ring_count, num_written, sample_rate))
+    {
+      pitch_publish(&worker->pitch, worker->pitch_tracker.reading);
+      did_work = true;
+    }
+
+    if (!did_work)
+    {
+      // NOTE(Ryan): A hop is milliseconds of audio even at the smallest size, so polling at 1ms is plenty
+      linux_sleep(MILLION(1));
+    }
+  }
+
+  return NULL;
+}
+
+INTERNAL void
+dsp_worker_start(DSPWorker *worker)
+{
+  ASSERT(!worker->running);
+  u32 running = true;
+  atomic_u32_store(&worker->running, &running);
+  worker->thread = start_thread(dsp_worker_thread, worker, true);
+}
+
+// IMPORTANT(Ryan): Joins, so the thread is guaranteed to be out of this library's code on return
+INTERNAL void
+dsp_worker_stop(DSPWorker *worker)
+{
+  if (!worker->running) return;
+  u32 running = false;
+  atomic_u32_store(&worker->running, &running);
+  thread_join(worker->thread);
+}
@@ -0,0 +1,801 @@
+// SPDX-License-Identifier: zlib-acknowledgement
+#if !defined(APP_DSP_H)
+#define APP_DSP_H
+
+typedef enum
+{
+  FFT_KERNEL_SCALAR = 0,
+  FFT_KERNEL_SSE4,
+  FFT_KERNEL_AVX2,
+  FFT_KERNEL_COUNT
+} FFT_KERNEL;
+
+#if LANE8_ENABLED
+  #define FFT_KERNEL_NATIVE FFT_KERNEL_AVX2
+#elif LANE4_ENABLED
+  #define FFT_KERNEL_NATIVE FFT_KERNEL_SSE4
+#else
+  #define FFT_KERNEL_NATIVE FFT_KERNEL_SCALAR
+#endif
+
+// NOTE(Ryan): Everything that depends only on the FFT size is computed once into an arena,
+// so executing a transform is just loads, multiplies and adds.
+// Data is split into separate real and imaginary arrays so butterflies map directly onto SIMD lanes
+typedef struct FFTPlan FFTPlan;
+struct FFTPlan
+{
+  u32 n;
+  u32 log2_n;
+
+  u32 *bit_reverse;
+  // NOTE(Ryan): Only pairs where i < reverse(i), so each swap happens once
+  u32 num_swaps;
+  u32 *swaps;
+
+  // NOTE(Ryan): Stage with butterfly half-length h reads its h twiddles contiguously from [h - 1, 2h - 1)
+  f32 *twiddles_re;
+  f32 *twiddles_im;
+};
+
+// NOTE(Ryan): Real input of length n is packed as n/2 complex values, so only a half size FFT is run.
+// Output is the n/2 + 1 non-redundant bins, as the rest are conjugate mirrors
+typedef struct RFFTPlan RFFTPlan;
+struct RFFTPlan
+{
+  u32 n;
+  FFTPlan *half;
+  // NOTE(Ryan): exp(-i*tau*k/n) for k in [0, n/4]
+  f32 *split_re;
+  f32 *split_im;
+};
+
+// NOTE(Ryan): Fixed point transform for targets without a fast FPU, like the Cortex-M4 panel controllers.
+// Samples and twiddles are Q15 and products Q30 in an s32. Each radix-2 stage halves its output, 
+// so n points come back as the DFT / n. The one way a stage can still grow is a twiddle rotating 
+// both components, and there the butterfly saturates rather than wraps.
+// IMPORTANT(Ryan): Nothing here calls libm, and everything after plan creation is integer, 
+// so every target gets the same bits for the same input
+typedef struct FFTPlanQ15 FFTPlanQ15;
+struct FFTPlanQ15
+{
+  u32 n;
+  u32 log2_n;
+
+  u32 num_swaps;
+  u32 *swaps;
+
+  // NOTE(Ryan): Same layout as FFTPlan
+  s16 *twiddles_re;
+  s16 *twiddles_im;
+};
+
+// NOTE(Ryan): Q16 log2 of a bin with no power, which has no log
+#define Q16_LOG2_POWER_FLOOR (-(64 << 16))
+
+typedef enum
+{
+  WINDOW_HANN = 0,
+  WINDOW_HAMMING,
+  WINDOW_BLACKMAN_HARRIS,
+  WINDOW_FLAT_TOP,
+  WINDOW_COUNT
+} WINDOW;
+
+// NOTE(Ryan): Every window is tabulated up front at the FFT size, so switching is just a pointer change
+typedef struct WindowTable WindowTable;
+struct WindowTable
+{
+  u32 n;
+  f32 *coefficients[WINDOW_COUNT];
+  // NOTE(Ryan): Mean of the coefficients, i.e. the amplitude a bin-centred sinusoid is scaled by
+  f32 coherent_gain[WINDOW_COUNT];
+  // NOTE(Ryan): dw/di scaled by n / tau, so a transform with them gives frequency offsets in bins.
+  // Only made for transforms that reassign
+  f32 *derivatives[WINDOW_COUNT];
+};
+
+// NOTE(Ryan): Groups FFT bins into bands whose width grows geometrically by growth,
+// so the low end isn't squashed into a few pixels. Band b covers bins [band_start[b], band_end[b])
+typedef struct LogBinMap LogBinMap;
+struct LogBinMap
+{
+  u32 num_bins;
+  f32 growth;
+
+  u32 num_bands;
+  u32 *band_start;
+  u32 *band_end;
+};
+
+// NOTE(Ryan): How the FFT bins are reduced to the bands drawn
+typedef enum
+{
+  SPECTRUM_SCALE_LOG_BANDS = 0,
+  SPECTRUM_SCALE_MEL,
+  SPECTRUM_SCALE_BARK,
+  SPECTRUM_SCALE_CONSTANT_Q,
+  SPECTRUM_SCALE_COUNT
+} SPECTRUM_SCALE;
+
+#define FILTERBANK_LOWEST_HZ 20.0f
+#define FILTERBANK_HIGHEST_HZ 20000.0f
+#define FILTERBANK_MEL_FILTERS 128
+#define FILTERBANK_BARK_STEP 0.25f
+#define FILTERBANK_CQ_LOWEST_HZ 32.7f
+#define FILTERBANK_CQ_BINS_PER_OCTAVE 12
+
+// NOTE(Ryan): Sparse matrix from FFT power to filter outputs, built once per size and sample rate.
+// Each filter's weights cover one contiguous run of bins, so a row is just where it starts and how long it is.
+// Filter k weights bins [first_bin[k], first_bin[k] + num_weights[k]) 
+// by weights[weight_offset[k]...]
+typedef struct Filterbank Filterbank;
+struct Filterbank
+{
+  SPECTRUM_SCALE scale;
+  u32 sample_rate;
+  u32 num_bins;
+
+  u32 num_filters;
+  u32 *first_bin;
+  u32 *num_weights;
+  u32 *weight_offset;
+  f32 *weights;
+};
+
+// NOTE(Ryan): Pitch classes, C = 0. Bins are assigned to the nearest equal-tempered semitone from A4
+#define CHROMA_BINS 12
+#define CHROMA_REFERENCE_HZ 440.0f
+#define CHROMA_REFERENCE_CLASS 9
+#define CHROMA_LOWEST_HZ 55.0f
+#define CHROMA_HIGHEST_HZ 5000.0f
+
+// NOTE(Ryan): Frequency rises with bin index, so bins of one pitch class are contiguous runs.
+// Accumulating is then a sum per run rather than a scatter per bin.
+// Bins too coarse to tell neighbouring semitones apart are left out
+typedef struct ChromaMap ChromaMap;
+struct ChromaMap
+{
+  u32 sample_rate;
+  u32 num_runs;
+  u32 *run_start;
+  u32 *run_end;
+  u32 *run_class;
+};
+
+// NOTE(Ryan): 0 to 11 are C major to B major, 12 to 23 C minor to B minor
+#define KEY_COUNT 24
+#define KEY_SMOOTHING_SECONDS 4.0f
+
+typedef struct KeyEstimator KeyEstimator;
+struct KeyEstimator
+{
+  f32 chroma[CHROMA_BINS];
+  u32 key;
+  // NOTE(Ryan): Correlation of the smoothed chroma with the key's profile, 0 before any chroma
+  f32 confidence;
+};
+
+// NOTE(Ryan): Analysis of the window ending at end_sample, 
+// which counts samples since the stream began so frames can be placed in time
+typedef struct SpectrumFrame SpectrumFrame;
+struct SpectrumFrame
+{
+  u64 end_sample;
+  u32 hop;
+  SPECTRUM_SCALE scale;
+  // NOTE(Ryan): Most recent tempo estimate as of this frame. Confidence is 0 while there isn't one
+  f32 tempo_bpm;
+  f32 tempo_confidence;
+  // NOTE(Ryan): Chroma sums to 1, or is all 0 in silence
+  f32 chroma[CHROMA_BINS];
+  u32 key;
+  f32 key_confidence;
+  f32 max_log_power;
+  // NOTE(Ryan): Varies with the FFT size, up to the max_bands allocated
+  u32 num_bands;
+  u32 max_bands;
+  f32 *band_log_power;
+};
+
+// NOTE(Ryan): Short FFTs are drawn on the band layout of this size, with their peaks refined to fill it in
+#define SPECTRUM_REFINE_TO_SIZE (1 << 13)
+
+// NOTE(Ryan): How a short FFT is spread onto the finer grid its bands are laid out on.
+// Bins are interpolated in log power, except around local maxima, which are fitted with a parabola 
+// through their neighbours (a Gaussian in power, close to the main lobe of Hann and Blackman-Harris). 
+// The parabola is redrawn as narrow as the finer grid's own lobe would be, so a tone stays a tone.
+// Reassignment places the peak from a second transform with the window's derivative instead.
+// That is exact for a lone tone under a window that reaches zero at its ends, so not Hamming, 
+// and fixes the parabola's bias with flat-top, but costs the extra transform
+typedef enum
+{
+  PEAK_REFINE_NONE = 0,
+  PEAK_REFINE_QUADRATIC,
+  PEAK_REFINE_REASSIGN,
+  PEAK_REFINE_COUNT
+} PEAK_REFINE;
+
+// NOTE(Ryan): Runs a transform once per hop of new audio, rather than once per rendered frame
+typedef struct STFT STFT;
+struct STFT
+{
+  u32 size;
+  u32 hop;
+  u64 next_frame_end;
+  u64 num_frames;
+
+  RFFTPlan *plan;
+  WindowTable *windows;
+  // NOTE(Ryan): Bands come from the filterbank if there is one, otherwise the bin map
+  LogBinMap *bin_map;
+  Filterbank *filterbank;
+  u32 num_bands;
+  f32 *windowed;
+  f32 *re;
+  f32 *im;
+  f32 *power;
+
+  // NOTE(Ryan): The bin map's grid is this many times finer than the FFT's bins. 
+  // Above 1, each frame is refined onto it before reducing to bands
+  u32 refine_factor;
+  f32 *log_power;
+  f32 *fine_log_power;
+  f32 *derivative_re;
+  f32 *derivative_im;
+
+  // NOTE(Ryan): Result of the most recent frame
+  u64 frame_end;
+  f32 peak_log_power;
+  f32 *band_log_power;
+};
+
+// NOTE(Ryan): One FFT size covering a contiguous run of the output bands
+typedef struct SpectrumLayer SpectrumLayer;
+struct SpectrumLayer
+{
+  STFT *stft;
+  u32 first_band;
+  // NOTE(Ryan): Added to the layer's log power so a sinusoid reads the same at any FFT size
+  f32 log_gain;
+};
+
+// NOTE(Ryan): Long windows resolve the lows, but smear transients in the highs where the log bands
+// are many bins wide anyway. So the wide bands come from a shorter FFT with a shorter hop instead
+#define SPECTRUM_MAX_LAYERS 2
+#define SPECTRUM_MULTI_RES_MIN_SIZE (1 << 11)
+#define SPECTRUM_SHORT_SIZE_DIVISOR 8
+typedef struct SpectrumAnalyser SpectrumAnalyser;
+struct SpectrumAnalyser
+{
+  u32 size;
+  SPECTRUM_SCALE scale;
+  // NOTE(Ryan): Filterbanks and the chroma map are built for a particular rate
+  u32 sample_rate;
+  u32 num_bands;
+  // NOTE(Ryan): Longest first. The last layer has the shortest hop, and so paces the output frames
+  u32 num_layers;
+  SpectrumLayer layers[SPECTRUM_MAX_LAYERS];
+
+  // NOTE(Ryan): From the first layer's power, as it has the finest bins
+  ChromaMap *chroma_map;
+  f32 chroma[CHROMA_BINS];
+};
+
+// NOTE(Ryan): Latest and previous frame, for the renderer to interpolate between
+typedef struct SpectrumHistory SpectrumHistory;
+struct SpectrumHistory
+{
+  SpectrumFrame frames[2];
+  u32 latest;
+  u64 num_frames;
+};
+
+// NOTE(Ryan): Display levels for each band, in [0, 1] of the panel height. 
+// They rise and fall towards the spectrum with separate time constants, applied as exact exponentials of dt 
+// so the motion is the same at any frame rate. Peaks hold at the highest level reached, then fall at a fixed rate
+#define SMOOTHING_ATTACK_SECONDS 0.03f
+#define SMOOTHING_RELEASE_SECONDS 0.2f
+#define PEAK_HOLD_SECONDS 0.6f
+#define PEAK_FALL_PER_SECOND 0.6f
+
+typedef struct SpectrumSmoothing SpectrumSmoothing;
+struct SpectrumSmoothing
+{
+  f32 *levels;
+  f32 *peaks;
+  // NOTE(Ryan): Seconds left before each peak starts to fall
+  f32 *peak_holds;
+};
+
+// NOTE(Ryan): Lock-free triple buffer. The writer and reader each own a slot outright,
+// and swap it with the shared middle slot, so neither ever waits on the other.
+// The reader always gets the most recently completed frame; older unread ones are dropped
+#define SPECTRUM_EXCHANGE_FRESH 0x4
+typedef struct SpectrumExchange SpectrumExchange;
+struct SpectrumExchange
+{
+  SpectrumFrame slots[3];
+  u32 back;
+  // NOTE(Ryan): Slot index, plus SPECTRUM_EXCHANGE_FRESH if written since the reader last took it
+  atomic_u32 middle;
+  u32 front;
+};
+
+// NOTE(Ryan): Onsets are peaks in spectral flux, i.e. how much band power rose since the previous frame.
+// A peak counts if it clears the median of recent flux by a margin, so the threshold follows the track's dynamics
+#define ONSET_MEDIAN_FRAMES 16
+#define ONSET_THRESHOLD_SCALE 1.5f
+#define ONSET_THRESHOLD_OFFSET 0.1f
+// NOTE(Ryan): Bands below this are treated as silence, so a track starting doesn't register as a huge rise
+#define ONSET_LOG_POWER_FLOOR 0.0f
+#define ONSET_MIN_GAP_SECONDS 0.05f
+// NOTE(Ryan): Intervals between onsets are folded by octaves into this range, i.e. 60 to 200 BPM
+#define BEAT_PERIOD_MIN_SECONDS 0.3f
+#define BEAT_PERIOD_MAX_SECONDS 1.0f
+#define BEAT_PERIOD_SMOOTHING 0.2f
+
+// NOTE(Ryan): Only touched by the worker. Fixed size, so nothing is allocated after init
+typedef struct OnsetDetector OnsetDetector;
+struct OnsetDetector
+{
+  u32 max_bands;
+  u32 num_bands;
+  SPECTRUM_SCALE scale;
+  f32 *previous_bands;
+  b32 has_previous;
+
+  // NOTE(Ryan): Flux of frame i is at flux[i % ONSET_MEDIAN_FRAMES]
+  u64 num_flux;
+  f32 flux[ONSET_MEDIAN_FRAMES];
+  // NOTE(Ryan): Flux of the latest frame, 0 straight after a reset
+  f32 strength;
+  f32 sorted[ONSET_MEDIAN_FRAMES];
+  u64 previous_end_sample;
+
+  u64 last_onset;
+  f32 beat_period;
+  u64 beat_anchor;
+};
+
+// NOTE(Ryan): Published by the worker as each onset is confirmed, and readable from any thread.
+// Timestamps are in the ring's sample clock, the same as SpectrumFrame end_sample
+#define ONSET_HISTORY 16
+typedef struct OnsetTrack OnsetTrack;
+struct OnsetTrack
+{
+  atomic_u64 num_onsets;
+  // NOTE(Ryan): Onset i is at onset_samples[i % ONSET_HISTORY]
+  atomic_u64 onset_samples[ONSET_HISTORY];
+  // NOTE(Ryan): Beats fall every beat_period samples on from beat_anchor. Period is 0 until one is known.
+  // The pair aren't updated together, so may briefly disagree for a frame
+  atomic_u64 beat_anchor;
+  atomic_u32 beat_period;
+};
+
+// NOTE(Ryan): Onset strength is resampled to a fixed rate regardless of the FFT hop, 
+// so a few seconds of it can be autocorrelated to find the dominant period
+#define TEMPO_ENVELOPE_HOP 512
+#define TEMPO_ENVELOPE_SLOTS 512
+#define TEMPO_UPDATE_SECONDS 0.5f
+#define TEMPO_MIN_BPM 60.0f
+#define TEMPO_MAX_BPM 200.0f
+// NOTE(Ryan): Autocorrelation also peaks at multiples of the beat. 
+// A log-Gaussian preference around a typical tempo decides between them
+#define TEMPO_PRIOR_BPM 120.0f
+#define TEMPO_PRIOR_OCTAVES 1.0f
+// NOTE(Ryan): Above this the beat tracker takes its period from the tempo rather than onset gaps
+#define TEMPO_CONFIDENT 0.3f
+
+// NOTE(Ryan): Only touched by the worker
+typedef struct TempoEstimator TempoEstimator;
+struct TempoEstimator
+{
+  u32 sample_rate;
+  // NOTE(Ryan): Slot s covers samples [s * TEMPO_ENVELOPE_HOP, (s + 1) * TEMPO_ENVELOPE_HOP) 
+  // and lives at envelope[s % TEMPO_ENVELOPE_SLOTS]
+  f32 envelope[TEMPO_ENVELOPE_SLOTS];
+  u64 last_slot;
+  u64 num_slots;
+  u64 next_update;
+
+  // NOTE(Ryan): Zero padded to twice the envelope, so the circular autocorrelation doesn't wrap
+  RFFTPlan *plan;
+  f32 *padded;
+  f32 *re;
+  f32 *im;
+
+  f32 bpm;
+  f32 confidence;
+};
+
+// NOTE(Ryan): YIN compares the latest YIN_WINDOW samples against themselves shifted by up to YIN_WINDOW,
+// so it reads the last 2 * YIN_WINDOW samples and finds periods down to sample_rate / YIN_WINDOW
+#define YIN_WINDOW 1024
+#define YIN_HOP 256
+// NOTE(Ryan): Largest normalised difference still counted as periodic
+#define YIN_THRESHOLD 0.15f
+#define YIN_MIN_HZ 50.0f
+#define YIN_MAX_HZ 2000.0f
+// NOTE(Ryan): Mean square below which the window is treated as silence
+#define YIN_SILENCE_POWER 1e-6f
+// NOTE(Ryan): The cross-correlation of YIN_WINDOW against 2 * YIN_WINDOW samples doesn't wrap in a transform this long
+#define YIN_FFT_SIZE (4 * YIN_WINDOW)
+
+typedef struct PitchReading PitchReading;
+struct PitchReading
+{
+  // NOTE(Ryan): 0 if unvoiced
+  f32 hz;
+  // NOTE(Ryan): 1 minus YIN's normalised difference at the chosen period, so 1 is perfectly periodic
+  f32 clarity;
+};
+STATIC_ASSERT(sizeof(PitchReading) == sizeof(u64));
+
+// NOTE(Ryan): Only touched by the worker
+typedef struct PitchTracker PitchTracker;
+struct PitchTracker
+{
+  u64 next_frame_end;
+  u64 frame_end;
+  // NOTE(Ryan): Last 2 * YIN_WINDOW samples up to frame_end, oldest first
+  f32 *samples;
+
+  RFFTPlan *rfft_plan;
+  FFTPlan *fft_plan;
+  f32 *padded;
+  f32 *window_re;
+  f32 *window_im;
+  f32 *re;
+  f32 *im;
+  // NOTE(Ryan): Cumulative mean normalised difference, indexed by lag
+  f32 *difference;
+
+  PitchReading reading;
+};
+
+// NOTE(Ryan): K-weighting is a high shelf then a high-pass, for L and R. The four biquads run side by side in one lane:
+// stage 1 on {L, R} of this frame, and stage 2 on {L, R} of stage 1's output for the previous frame.
+// So the weighted signal lags a frame behind, which a meter can't notice.
+// Per lane, in transposed direct form II
+#define K_WEIGHTING_LANES 4
+typedef struct KWeighting KWeighting;
+struct KWeighting
+{
+  f32 b0[K_WEIGHTING_LANES];
+  f32 b1[K_WEIGHTING_LANES];
+  f32 b2[K_WEIGHTING_LANES];
+  f32 a1[K_WEIGHTING_LANES];
+  f32 a2[K_WEIGHTING_LANES];
+  f32 z1[K_WEIGHTING_LANES];
+  f32 z2[K_WEIGHTING_LANES];
+  f32 y[K_WEIGHTING_LANES];
+};
+
+// NOTE(Ryan): EBU R128. Mean square is gathered in 100ms sub-blocks; momentary is the last 4, short-term the last 30.
+// Integrated keeps every 400ms block in a histogram, so it runs for as long as the track without growing
+#define LOUDNESS_SUBBLOCKS_PER_SECOND 10
+#define LOUDNESS_MOMENTARY_SUBBLOCKS 4
+#define LOUDNESS_SHORT_TERM_SUBBLOCKS 30
+#define LOUDNESS_ABSOLUTE_GATE -70.0f
+#define LOUDNESS_RELATIVE_GATE -10.0f
+// NOTE(Ryan): Histogram spans the absolute gate up to +10 LUFS
+#define LOUDNESS_HISTOGRAM_LU 80
+#define LOUDNESS_HISTOGRAM_BINS_PER_LU 10
+#define LOUDNESS_HISTOGRAM_BINS (LOUDNESS_HISTOGRAM_LU * LOUDNESS_HISTOGRAM_BINS_PER_LU)
+#define LOUDNESS_HISTOGRAM_STEP (1.0f / LOUDNESS_HISTOGRAM_BINS_PER_LU)
+
+// NOTE(Ryan): Only touched by the audio thread, other than the atomics. Fixed size, so the callback never allocates
+typedef struct LoudnessMeter LoudnessMeter;
+struct LoudnessMeter
+{
+  u32 sample_rate;
+  KWeighting filter;
+
+  u32 subblock_length;
+  u32 subblock_filled;
+  f32 subblock_energy;
+  // NOTE(Ryan): Mean square of sub-block i, summed over channels, at subblocks[i % LOUDNESS_SHORT_TERM_SUBBLOCKS]
+  f32 subblocks[LOUDNESS_SHORT_TERM_SUBBLOCKS];
+  u64 num_subblocks;
+
+  u32 histogram[LOUDNESS_HISTOGRAM_BINS];
+  // NOTE(Ryan): Mean square at the centre of each histogram bin
+  f32 bin_energy[LOUDNESS_HISTOGRAM_BINS];
+
+  // NOTE(Ryan): Set by anyone to start integrating afresh, e.g. on a new track
+  atomic_u32 reset_requested;
+  // NOTE(Ryan): LUFS, -inf until there's enough audio
+  atomic_f32 momentary;
+  atomic_f32 short_term;
+  atomic_f32 integrated;
+};
+
+// NOTE(Ryan): Phase correlation sum(L*R) / sqrt(sum(L^2) * sum(R^2)) over a sliding window. 
+// The window is a ring of chunk sums, so each sample is added once and the totals never drift
+#define CORRELATION_CHUNK_FRAMES 512
+#define CORRELATION_CHUNKS 32
+// NOTE(Ryan): Mean square below which the window is treated as silence, reading 0
+#define CORRELATION_SILENCE_POWER 1e-8f
+
+typedef struct StereoCorrelation StereoCorrelation;
+struct StereoCorrelation
+{
+  // NOTE(Ryan): L*R, L^2 and R^2 of the chunk being filled
+  f32 partial_lr;
+  f32 partial_ll;
+  f32 partial_rr;
+  u32 partial_frames;
+
+  f32 chunk_lr[CORRELATION_CHUNKS];
+  f32 chunk_ll[CORRELATION_CHUNKS];
+  f32 chunk_rr[CORRELATION_CHUNKS];
+  u64 num_chunks;
+
+  // NOTE(Ryan): In [-1, 1]. +1 is mono, 0 unrelated channels, -1 one channel inverted
+  atomic_f32 correlation;
+};
+
+// NOTE(Ryan): The vectorscope plots this many of the latest stereo frames, 
+// rotated 45 degrees so mono is vertical and out of phase is horizontal
+#define GONIOMETER_POINTS 8192
+
+// NOTE(Ryan): Energy at a few chosen frequencies, updated every audio block rather than every FFT hop.
+// Each band is a sliding DFT over the last window samples, Hann windowed by combining it 
+// with the sliding DFTs a bin either side: 0.5*X[f] - 0.25*(X[f - 1] + X[f + 1]).
+// Every resonator is x[n] + r*e^(jw)*S[n-1] - r^window*e^(jw*window)*x[n-window].
+// Undamped (r = 1), rounding error in the cancelling term is never forgotten and the bands drift over hours; 
+// with r a little under 1 it dies away within seconds, at the cost of tapering the window by r^window
+#define SLIDING_DFT_MAX_BANDS 16
+#define SLIDING_DFT_MAX_WINDOW 4096
+#define SLIDING_DFT_WINDOW_TAPER 0.99
+// NOTE(Ryan): Mono samples staged at a time, so the resonators stay in registers over a run of samples
+#define SLIDING_DFT_CHUNK 256
+#define SLIDING_DFT_DEFAULT_BANDS 12
+#define SLIDING_DFT_DEFAULT_LOWEST_HZ 50.0f
+#define SLIDING_DFT_DEFAULT_HIGHEST_HZ 10000.0f
+#define SLIDING_DFT_DEFAULT_WINDOW 2048
+STATIC_ASSERT(SLIDING_DFT_MAX_BANDS % LANE_WIDTH == 0);
+
+// NOTE(Ryan): A set of bands for the audio thread to take up. Frequencies at or above Nyquist read 0
+typedef struct SlidingDFTConfig SlidingDFTConfig;
+struct SlidingDFTConfig
+{
+  u32 num_bands;
+  u32 window;
+  f32 hz[SLIDING_DFT_MAX_BANDS];
+};
+
+// NOTE(Ryan): Only touched by the audio thread, other than the request and the atomics.
+// Resonators are in three runs of SLIDING_DFT_MAX_BANDS: the band's own frequency, a bin above, a bin below
+typedef struct SlidingDFT SlidingDFT;
+struct SlidingDFT
+{
+  u32 sample_rate;
+  SlidingDFTConfig config;
+
+  f32 rotate_re[3 * SLIDING_DFT_MAX_BANDS];
+  f32 rotate_im[3 * SLIDING_DFT_MAX_BANDS];
+  f32 comb_re[3 * SLIDING_DFT_MAX_BANDS];
+  f32 comb_im[3 * SLIDING_DFT_MAX_BANDS];
+  f32 state_re[3 * SLIDING_DFT_MAX_BANDS];
+  f32 state_im[3 * SLIDING_DFT_MAX_BANDS];
+
+  // NOTE(Ryan): 2 / (sum of the tapered Hann window)^2, so a sinusoid's energy comes out as its mean square
+  f32 energy_scale;
+
+  // NOTE(Ryan): Last window mono samples, the oldest at history_at
+  f32 history[SLIDING_DFT_MAX_WINDOW];
+  u32 history_at;
+  f32 input[SLIDING_DFT_CHUNK];
+  f32 delayed[SLIDING_DFT_CHUNK];
+
+  // NOTE(Ryan): Written by one other thread only while request_pending is 0, then set to 1 for the audio thread
+  SlidingDFTConfig request;
+  atomic_u32 request_pending;
+
+  // NOTE(Ryan): Mean square of each band's sinusoid, i.e. amplitude^2 / 2. 
+  // Stored band by band, so a reader may see one block's bands mixed with the next's
+  atomic_f32 energies[SLIDING_DFT_MAX_BANDS];
+  atomic_u32 num_bands;
+  atomic_u64 num_blocks;
+};
+
+// NOTE(Ryan): Filter shapes from the Audio EQ Cookbook (R. Bristow-Johnson). gain_db is ignored by the passes
+typedef enum
+{
+  BIQUAD_BYPASS = 0,
+  BIQUAD_HIGH_PASS,
+  BIQUAD_LOW_PASS,
+  BIQUAD_PEAK,
+  BIQUAD_LOW_SHELF,
+  BIQUAD_HIGH_SHELF,
+  BIQUAD_COUNT
+} BIQUAD;
+
+typedef struct BiquadParams BiquadParams;
+struct BiquadParams
+{
+  BIQUAD type;
+  f32 hz;
+  f32 q;
+  f32 gain_db;
+};
+
+// NOTE(Ryan): A fixed cascade of biquads on both channels, run in place on the stream before anything analyses it.
+// Default is a 4th order Butterworth high-pass for DC and rumble, then a peaking band per octave.
+// Lanes hold {L, R} of each stage, and the cascade is pipelined like K-weighting: 
+// each stage takes the stage before's output from the previous frame, so every stage runs side by side.
+// The stream comes out EQ_STAGES - 1 frames late, well under a millisecond. 
+// Stages are grouped a lane width at a time, with the first stage of a group in its top pair
+#define EQ_STAGES 12
+#define EQ_LANES (2 * EQ_STAGES)
+#define EQ_GROUP_WIDTH ((LANE_WIDTH > 1) ? LANE_WIDTH : 2)
+STATIC_ASSERT(EQ_LANES % EQ_GROUP_WIDTH == 0);
+#define EQ_RUMBLE_HZ 25.0f
+#define EQ_USER_BANDS 10
+#define EQ_FIRST_USER_STAGE (EQ_STAGES - EQ_USER_BANDS)
+#define EQ_LOWEST_BAND_HZ 31.25f
+#define EQ_BAND_Q 1.41f
+#define EQ_MAX_GAIN_DB 12.0f
+
+typedef struct EqualiserConfig EqualiserConfig;
+struct EqualiserConfig
+{
+  BiquadParams stages[EQ_STAGES];
+};
+
+// NOTE(Ryan): Only touched by the audio thread, other than the request. Transposed direct form II per lane
+typedef struct Equaliser Equaliser;
+struct Equaliser
+{
+  u32 sample_rate;
+  EqualiserConfig config;
+
+  f32 b0[EQ_LANES];
+  f32 b1[EQ_LANES];
+  f32 b2[EQ_LANES];
+  f32 a1[EQ_LANES];
+  f32 a2[EQ_LANES];
+  f32 z1[EQ_LANES];
+  f32 z2[EQ_LANES];
+  f32 y[EQ_LANES];
+
+  // NOTE(Ryan): Written by one other thread only while request_pending is 0, then set to 1 for the audio thread
+  EqualiserConfig request;
+  atomic_u32 request_pending;
+};
+
+// NOTE(Ryan): Uniformly partitioned overlap-save, so cost per block is the same whatever the IR length.
+// The IR is cut into CONVOLVER_BLOCK tap partitions and each kept as a spectrum. Every block, 
+// the last 2 blocks of input are transformed once into a ring of past spectra, 
+// and the output spectrum is the sum over partitions of each one times the input spectrum that many blocks ago.
+// Output is one CONVOLVER_BLOCK late
+#define CONVOLVER_BLOCK 512
+#define CONVOLVER_FFT_SIZE (2 * CONVOLVER_BLOCK)
+// NOTE(Ryan): CONVOLVER_BLOCK + 1 bins, padded with zeros to a whole number of lanes
+#define CONVOLVER_STRIDE (CONVOLVER_BLOCK + 8)
+#define CONVOLVER_MAX_TAPS (1 << 18)
+#define CONVOLVER_MAX_PARTITIONS (CONVOLVER_MAX_TAPS / CONVOLVER_BLOCK)
+#define CONVOLVER_SPECTRA (2 * CONVOLVER_MAX_PARTITIONS)
+// NOTE(Ryan): Partitions transformed per convolver_build on the render thread, 
+// so the longest IR is spread over about a quarter of a second of frames rather than stalling one
+#define CONVOLVER_BUILD_PARTITIONS 32
+
+#define REVERB_RT60_SECONDS 2.0f
+#define REVERB_SECONDS 2.5f
+#define REVERB_PREDELAY_SECONDS 0.02f
+// NOTE(Ryan): Energy of the tail against the direct sound
+#define REVERB_WET_ENERGY 0.3f
+
+typedef struct Convolver Convolver;
+struct Convolver
+{
+  RFFTPlan *plan;
+
+  // NOTE(Ryan): Two sets of IR spectra, each [channel][partition][bin], so a new IR is built into the set 
+  // the audio thread isn't reading, which only changes over at the start of a callback
+  f32 *filter_re[2];
+  f32 *filter_im[2];
+  u32 num_partitions[2];
+  atomic_u32 active_set;
+  // NOTE(Ryan): Set to 1 once the other set is ready. The audio thread switches over and clears it
+  atomic_u32 request_pending;
+
+  // NOTE(Ryan): Only touched by the audio thread. Input spectra are a ring of [partition][channel][bin]
+  f32 *history_re;
+  f32 *history_im;
+  u32 history_at;
+  // NOTE(Ryan): Blocks since the ring was last started afresh, so stale spectra are never summed
+  u32 num_blocks;
+  f32 input[2][CONVOLVER_FFT_SIZE];
+  f32 output[2][CONVOLVER_BLOCK];
+  u32 fill;
+  f32 sum_re[CONVOLVER_STRIDE];
+  f32 sum_im[CONVOLVER_STRIDE];
+  f32 time[CONVOLVER_FFT_SIZE];
+
+  // NOTE(Ryan): Only touched by the thread making requests. The IR being built into the inactive set,
+  // and the next partition of it to transform
+  f32 *padded;
+  f32 *build_ir[2];
+  u32 build_taps;
+  u32 build_cursor;
+  b32 building;
+};
+
+// NOTE(Ryan): Two decks, each staging what its stream decoded this device callback, 
+// mixed with gains cos and sin of position * pi/2 for the deck faded from and the one faded to.
+// A new request onto the other deck starts from 1 - position, so the deck that stays keeps its gain 
+// and the replaced one hands its gain straight to the new track
+#define CROSSFADE_SECONDS 3.0f
+#define CROSSFADE_MAX_FRAMES 8192
+
+typedef struct Crossfader Crossfader;
+struct Crossfader
+{
+  // NOTE(Ryan): Only touched by the audio thread
+  f32 staged[2][2 * CROSSFADE_MAX_FRAMES];
+  u32 num_staged[2];
+  u32 incoming;
+  f32 position;
+  f32 step;
+
+  // NOTE(Ryan): 1 until position reaches 1, so the deck faded from can be stopped
+  atomic_u32 fading;
+
+  // NOTE(Ryan): Written by one other thread only while request_pending is 0, then set to 1 for the audio thread
+  u32 request_deck;
+  u32 request_frames;
+  atomic_u32 request_pending;
+};
+
+#define FFT_SIZE_MIN (1 << 9)
+#define FFT_SIZE_MAX (1 << 16)
+#define FFT_SIZE_DEFAULT (1 << 13)
+#define FFT_SIZE_COUNT 8
+STATIC_ASSERT((FFT_SIZE_MIN << (FFT_SIZE_COUNT - 1)) == FFT_SIZE_MAX);
+// NOTE(Ryan): Overlap is kept constant, so smaller sizes also update more often
+#define FFT_HOP_DIVISOR 4
+// NOTE(Ryan): Only used if the device won't say what rate it runs at
+#define DSP_DEFAULT_SAMPLE_RATE 44100
+
+// NOTE(Ryan): Everything the worker reads is reached from here, as it can't touch g_state.
+// The thread function lives in the reloadable library, so it's stopped before each dlclose
+typedef struct DSPWorker DSPWorker;
+struct DSPWorker
+{
+  thread_handle thread;
+  atomic_u32 running;
+
+  f32 *ring;
+  u32 ring_count;
+  atomic_u64 *ring_num_written;
+
+  atomic_u32 active_window;
+  atomic_u32 requested_fft_size;
+  atomic_u32 active_scale;
+  atomic_u32 active_refine;
+  // NOTE(Ryan): Raylib converts every stream to the device's rate before any processor sees it,
+  // so this is the rate of everything analysed and processed, whatever each track was encoded at.
+  // The device keeps its rate while open, so this is set before the thread starts and only read after
+  u32 sample_rate;
+
+  // NOTE(Ryan): Only touched by the worker. Each size is built the first time it's asked for,
+  // then kept, so switching back and forth costs nothing.
+  // At most one per size and scale, as the rate never changes, so the arena is bounded
+  MemArena *arena;
+  f32 bin_growth;
+  u32 fft_size;
+  SpectrumAnalyser *analysers[FFT_SIZE_COUNT][SPECTRUM_SCALE_COUNT];
+
+  SpectrumExchange exchange;
+  OnsetDetector onset_detector;
+  OnsetTrack onsets;
+  TempoEstimator tempo;
+  KeyEstimator key;
+  PitchTracker pitch_tracker;
+  // NOTE(Ryan): A PitchReading, packed so hz and clarity always arrive together
+  atomic_u64 pitch;
+};
+
+#endif
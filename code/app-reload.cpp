@@ -28,6 +28,7 @@ State *g_state = NULL;
 GLOBAL u64 g_active_button_id;
 
 #include "app-assets.cpp"
+#include "app-dsp.cpp"
 
 INTERNAL Rectangle
 cut_rect_left(Rectangle rect, f32 t)
@@ -272,6 +273,22 @@ push_line(Vector2 start, Vector2 end, f32 thickness, Color c)
 }
 
 
+// NOTE(Ryan): Squares of side 2 * radius. Older points come first and are drawn fainter
+INTERNAL void
+push_points(f32 *points, u32 num_points, f32 radius, Color c)
+{
+  RenderElement *re = MEM_ARENA_PUSH_STRUCT_ZERO(g_state->frame_arena, RenderElement);
+  re->type = RE_POINTS;
+  re->z = g_state->z_layer_stack->value;
+  re->colour = {c.r, c.g, c.b, (u8)(c.a * g_state->alpha_stack->value)};
+
+  re->points = points;
+  re->num_points = num_points;
+  re->radius = radius;
+  SLL_QUEUE_PUSH(g_state->render_element_first, g_state->render_element_last, re);
+  g_state->render_element_queue_count += 1;
+}
+
 INTERNAL void
 push_texture(Texture t, Vector2 p, f32 scale, Color c)
 {
@@ -375,6 +392,30 @@ render_elements(void)
       {
         DrawLineEx({re->rec.x, re->rec.y}, {re->rec.width, re->rec.height}, re->thickness, re->colour);
       } break;
+      case RE_POINTS:
+      {
+        // NOTE(Ryan): Quads go straight into the rlgl batch, so thousands of points are one draw call 
+        // rather than a DrawRectangle each. Alpha steps up per group so the trail fades with age
+        f32 h = re->radius;
+        u32 num_groups = (re->num_points + POINTS_PER_GROUP - 1) / POINTS_PER_GROUP;
+        for (u32 group = 0; group < num_groups; group += 1)
+        {
+          u32 start = group * POINTS_PER_GROUP;
+          u32 count = MIN(POINTS_PER_GROUP, re->num_points - start);
+          rlCheckRenderBatchLimit(4 * count);
+          rlBegin(RL_QUADS);
+          rlColor4ub(re->colour.r, re->colour.g, re->colour.b, (u8)(re->colour.a * (group + 1) / num_groups));
+          f32 *p = re->points + 2 * start;
+          for (u32 point = 0; point < count; point += 1, p += 2)
+          {
+            rlVertex2f(p[0] - h, p[1] - h);
+            rlVertex2f(p[0] - h, p[1] + h);
+            rlVertex2f(p[0] + h, p[1] + h);
+            rlVertex2f(p[0] + h, p[1] - h);
+          }
+          rlEnd();
+        }
+      } break;
     }
   }
 
@@ -404,80 +445,179 @@ consume_left_click(void)
 INTERNAL void 
 music_callback(void *buffer, unsigned int frames)
 {
-  // NOTE(Ryan): Don't overwrite buffer on this run
-  if (frames >= NUM_SAMPLES) frames = NUM_SAMPLES - 1;
+  // NOTE(Ryan): Filtered in place, so it's what gets played as well as what's analysed
+  u32 eq_sample_rate = g_state->dsp_worker.sample_rate;
+  equaliser_process(&g_state->equaliser, (f32 *)buffer, frames, eq_sample_rate);
+  convolver_process(&g_state->convolver, (f32 *)buffer, frames);
 
   // NOTE(Ryan): Raylib normalises to f32 stereo for all sources
   f32 *norm_buf = (f32 *)buffer;
+  SampleRing *ring = &g_state->samples_ring;
+  u64 num_written = atomic_u64_load(&ring->num_written);
   for (u32 i = 0; i < frames * 2; i += 2)
   {
     f32 left = norm_buf[i];
     f32 right = norm_buf[i + 1];
 
-    g_state->samples_ring.samples[g_state->samples_ring.head] = MAX(left, right);
-    g_state->samples_ring.head = (g_state->samples_ring.head + 1) % NUM_SAMPLES;
+    ring->samples[num_written % RING_SAMPLES] = MAX(left, right);
+    u32 stereo_at = 2 * (num_written % STEREO_RING_FRAMES);
+    ring->stereo[stereo_at] = left;
+    ring->stereo[stereo_at + 1] = right;
+    num_written += 1;
   }
+  atomic_u64_store(&ring->num_written, &num_written);
+
+  u32 sample_rate = g_state->dsp_worker.sample_rate;
+  loudness_meter_process(&g_state->loudness, norm_buf, frames, sample_rate);
+  stereo_correlation_process(&g_state->stereo_correlation, norm_buf, frames);
+  sliding_dft_process(&g_state->sliding_dft, norm_buf, frames, sample_rate);
 }
 
-EXPORT void 
-code_preload(State *state)
+// NOTE(Ryan): Each deck's stream hands what it decoded to the crossfader rather than to raylib's mixer
+INTERNAL void
+deck_0_callback(void *buffer, unsigned int frames)
 {
-  MusicFile *active = DEREF_MUSIC_FILE_HANDLE(state->active_music_handle);
-  if (!ZERO_MUSIC_FILE(active)) 
-  {
-    DetachAudioStreamProcessor(active->music.stream, music_callback);
-  }
+  crossfader_stage(&g_state->crossfader, 0, (f32 *)buffer, frames);
+}
 
-  profiler_init();
-  
-  assets_preload(state);
+INTERNAL void
+deck_1_callback(void *buffer, unsigned int frames)
+{
+  crossfader_stage(&g_state->crossfader, 1, (f32 *)buffer, frames);
 }
 
-EXPORT void 
-code_postload(State *state)
+INTERNAL AudioCallback
+deck_callback(u32 deck)
+{
+  return (deck == 0) ? deck_0_callback : deck_1_callback;
+}
+
+// NOTE(Ryan): Raylib's mixed output, which only ever has the crossfader's mix in it. 
+// So analysis sees one continuous stream, straight through track changes
+INTERNAL void
+mixer_callback(void *buffer, unsigned int frames)
 {
+  u32 delivered = crossfader_mix(&g_state->crossfader, (f32 *)buffer, frames);
+  // NOTE(Ryan): Paused or nothing loaded, so analysis holds where it was
+  if (delivered == 0) return;
+
+  music_callback(buffer, frames);
+
+  f32 *samples = (f32 *)buffer;
+  for (u32 i = 0; i < 2 * frames; i += 1) samples[i] *= MUSIC_VOLUME;
+}
+
+// NOTE(Ryan): Processors are function pointers into this library, so come off before each reload
+INTERNAL void
+audio_processors_detach(State *state)
+{
+  DetachAudioMixedProcessor(mixer_callback);
   MusicFile *active = DEREF_MUSIC_FILE_HANDLE(state->active_music_handle);
-  if (!ZERO_MUSIC_FILE(active)) 
-  {
-    AttachAudioStreamProcessor(active->music.stream, music_callback);
-  }
+  MusicFile *fading = DEREF_MUSIC_FILE_HANDLE(state->fading_music_handle);
+  if (!ZERO_MUSIC_FILE(active)) DetachAudioStreamProcessor(active->music.stream, deck_callback(state->active_deck));
+  if (!ZERO_MUSIC_FILE(fading)) DetachAudioStreamProcessor(fading->music.stream, deck_callback(state->active_deck ^ 1));
 }
 
-EXPORT void
-code_profiler_end_and_print(State *state)
+INTERNAL void
+audio_processors_attach(State *state)
 {
-  profiler_end_and_print();
+  MusicFile *active = DEREF_MUSIC_FILE_HANDLE(state->active_music_handle);
+  MusicFile *fading = DEREF_MUSIC_FILE_HANDLE(state->fading_music_handle);
+  if (!ZERO_MUSIC_FILE(active)) AttachAudioStreamProcessor(active->music.stream, deck_callback(state->active_deck));
+  if (!ZERO_MUSIC_FILE(fading)) AttachAudioStreamProcessor(fading->music.stream, deck_callback(state->active_deck ^ 1));
+  AttachAudioMixedProcessor(mixer_callback);
 }
 
-INTERNAL f32
-hann_function(f32 sample, f32 t)
+// NOTE(Ryan): Raylib has no call for the device's rate, but a sound is always converted to it on load
+// and reports it, so a throwaway one finds it out
+INTERNAL u32
+audio_device_sample_rate(void)
 {
-  f32 h = 0.5f - 0.5f * F32_COS(F32_TAU * t);
-  return sample * h;
+  f32 frames[2 * 16] = ZERO_STRUCT;
+  Wave wave = ZERO_STRUCT;
+  wave.frameCount = ARRAY_COUNT(frames) / 2;
+  wave.sampleRate = DSP_DEFAULT_SAMPLE_RATE;
+  wave.sampleSize = 32;
+  wave.channels = 2;
+  wave.data = frames;
+
+  Sound sound = LoadSoundFromWave(wave);
+  u32 sample_rate = sound.stream.sampleRate;
+  UnloadSound(sound);
+
+  if (sample_rate == 0)
+  {
+    WARN("Can't find the audio device's sample rate, assuming %u\n", DSP_DEFAULT_SAMPLE_RATE);
+    sample_rate = DSP_DEFAULT_SAMPLE_RATE;
+  }
+  return sample_rate;
 }
 
-// NOTE(Ryan): Modified from https://rosettacode.org/wiki/Fast_Fourier_transform#Python
-// cooley-tukey algorithm O(nlogn) for pow2
-INTERNAL void 
-fft(f32 *in, u32 stride, f32z *out, u32 n)
+// NOTE(Ryan): m goes on the deck that isn't live and is faded up over CROSSFADE_SECONDS, 
+// or cut straight to if nothing was playing. Whatever was still fading out on that deck is stopped.
+// Picking the track being faded out just turns the fade round
+INTERNAL void
+crossfade_to_music(MusicFile *m)
 {
-  if (n == 1) 
+  MusicFile *active = DEREF_MUSIC_FILE_HANDLE(g_state->active_music_handle);
+  MusicFile *fading = DEREF_MUSIC_FILE_HANDLE(g_state->fading_music_handle);
+  if (m == active)
   {
-    out[0] = in[0];
+    StopMusicStream(m->music);
+    PlayMusicStream(m->music);
     return;
   }
 
-  fft(in, stride*2, out, n/2);
-  fft(in + stride, stride*2, out + n/2, n/2);
-
-  for (u32 k = 0; k < n/2; ++k)
+  u32 deck = g_state->active_deck ^ 1;
+  if (m != fading)
   {
-    f32 t = (f32)k/n;
-    f32z v = f32z_exp(-f32z_I*F32_TAU*t) * out[k + n/2];
-    f32z e = out[k];
-    out[k] = e + v;
-    out[k + n/2] = e - v;
+    if (!ZERO_MUSIC_FILE(fading))
+    {
+      StopMusicStream(fading->music);
+      DetachAudioStreamProcessor(fading->music.stream, deck_callback(deck));
+    }
+    AttachAudioStreamProcessor(m->music.stream, deck_callback(deck));
+    PlayMusicStream(m->music);
   }
+
+  u32 sample_rate = g_state->dsp_worker.sample_rate;
+  g_state->crossfade_frames = ZERO_MUSIC_FILE(active) ? 0 : (u32)(CROSSFADE_SECONDS * sample_rate);
+  g_state->crossfade_dirty = true;
+  g_state->fading_music_handle = g_state->active_music_handle;
+  g_state->active_music_handle = TO_HANDLE(m);
+  g_state->active_deck = deck;
+
+  u32 reset = true;
+  atomic_u32_store(&g_state->loudness.reset_requested, &reset);
+}
+
+EXPORT void 
+code_preload(State *state)
+{
+  if (state->is_initialised) audio_processors_detach(state);
+
+  // IMPORTANT(Ryan): The worker runs code from this library, so must be out of it before dlclose
+  dsp_worker_stop(&state->dsp_worker);
+
+  profiler_init();
+  
+  assets_preload(state);
+}
+
+EXPORT void 
+code_postload(State *state)
+{
+  // NOTE(Ryan): The audio thread can call in before the first update
+  g_state = state;
+  if (state->is_initialised) audio_processors_attach(state);
+
+  if (state->is_initialised) dsp_worker_start(&state->dsp_worker);
+}
+
+EXPORT void
+code_profiler_end_and_print(State *state)
+{
+  profiler_end_and_print();
 }
 
 typedef enum 
@@ -709,14 +849,7 @@ draw_scroll_region(Rectangle r)
     }
     if (bs & BS_CLICKED)
     {
-      StopMusicStream(active->music);
-      DetachAudioStreamProcessor(active->music.stream, music_callback);
-
-      g_state->active_music_handle = TO_HANDLE(m);
-
-      AttachAudioStreamProcessor(m->music.stream, music_callback);
-      SetMusicVolume(m->music, 0.5f);
-      PlayMusicStream(m->music);
+      crossfade_to_music(m);
     } 
     else if (bs & BS_HOVERING)
     {
@@ -876,11 +1009,63 @@ handle_text_input_u32(Rectangle r, u32 *value)
 
 } */
 
+INTERNAL void
+draw_goniometer(Rectangle r)
+{
+  push_rect(r, COLOR_BG0);
+
+  // NOTE(Ryan): Guides for mono on the vertical, and left or right alone on the diagonals
+  Vector2 centre = {r.x + r.width * 0.5f, r.y + r.height * 0.5f};
+  push_line({centre.x, r.y}, {centre.x, r.y + r.height}, 1.f, COLOR_BG1);
+  push_line({r.x, r.y}, {r.x + r.width, r.y + r.height}, 1.f, COLOR_BG1);
+  push_line({r.x + r.width, r.y}, {r.x, r.y + r.height}, 1.f, COLOR_BG1);
+
+  SampleRing *ring = &g_state->samples_ring;
+  u64 num_written = atomic_u64_load(&ring->num_written);
+  u32 num_frames = (u32)MIN(num_written, GONIOMETER_POINTS);
+  if (num_frames == 0) return;
+
+  f32 *unwrapped = MEM_ARENA_PUSH_ARRAY(g_state->frame_arena, f32, 2 * num_frames + 2);
+  f32 *samples = stereo_ring_unwrap(ring->stereo, STEREO_RING_FRAMES, num_written, num_frames, unwrapped);
+  f32 *xy = MEM_ARENA_PUSH_ARRAY(g_state->frame_arena, f32, 2 * num_frames);
+  goniometer_points(samples, num_frames, centre.x, centre.y, r.width * 0.5f, xy);
+  push_points(xy, num_frames, 1.f, COLOR_BLUE_ACCENT);
+}
+
+// NOTE(Ryan): A light per sliding DFT band, lowest on the left, brightening over the top 60dB
+INTERNAL void
+draw_band_lights(Rectangle r)
+{
+  SlidingDFT *bank = &g_state->sliding_dft;
+  u32 num_bands = atomic_u32_load(&bank->num_bands);
+  if (num_bands == 0) return;
+
+  f32 floor_db = -60.0f;
+  Color off = COLOR_BG0, on = COLOR_ORANGE_ACCENT;
+  f32 light_width = r.width / num_bands;
+  for (u32 b = 0; b < num_bands; b += 1)
+  {
+    f32 energy = atomic_f32_load(&bank->energies[b]);
+    f32 db = (energy > 0.0f) ? f32_fast_db_from_power(energy) : floor_db;
+    f32 t = CLAMP(0.0f, (db - floor_db) / -floor_db, 1.0f);
+    Rectangle light = {r.x + b * light_width, r.y, light_width * 0.8f, r.height};
+    push_rect(light, lerp_color(&off, &on, t), 0.3f, 8);
+  }
+}
+
 INTERNAL void
 draw_correlation_region(Rectangle r, f32 correlation)
 {
   push_rect(r, COLOR_BG1);
 
+  f32 scope_side = r.height * 0.9f;
+  f32 scope_margin = (r.height - scope_side) * 0.5f;
+  draw_goniometer({r.x + scope_margin, r.y + scope_margin, scope_side, scope_side});
+
+  f32 lights_width = r.width * 0.25f;
+  draw_band_lights({r.x + r.width - lights_width - scope_margin, r.y + r.height * 0.4f, 
+                    lights_width, r.height * 0.2f});
+
   char *label = "Music Correlation:";
   f32 font_size = g_state->font.baseSize * 2.f;
   Vector2 text_size = MeasureTextEx(g_state->font, label, font_size, 0.f);
@@ -889,26 +1074,55 @@ draw_correlation_region(Rectangle r, f32 correlation)
   Rectangle rect = align_rect(r, size, RA_CENTRE);
   push_text(label, g_state->font, font_size, {rect.x, rect.y}, COLOR_FONT);
 
-  const char *text = "";
+  // NOTE(Ryan): Negative means the channels partly cancel when summed to mono
   Color c = ZERO_STRUCT;
-  if (correlation < 0.25f)
-  {
-    text = "low"; c = COLOR_GREEN_ACCENT;
-  }
-  else if (correlation > 0.75f)
-  {
-    text = "high"; c = COLOR_RED_ACCENT;
-  }
-  else
+  if (correlation < 0.0f) c = COLOR_RED_ACCENT;
+  else if (correlation < 0.5f) c = COLOR_YELLOW_ACCENT;
+  else c = COLOR_GREEN_ACCENT;
+  String8 text = str8_fmt(g_state->frame_arena, "%+.2f", correlation);
+  push_text((const char *)text.content, g_state->font, font_size, {rect.x + rect.width + 5.f, rect.y}, c);
+
+  // NOTE(Ryan): Marker on a -1 to +1 scale under the label
+  f32 scale_y = rect.y + rect.height + margin.y;
+  Vector2 scale_start = {rect.x, scale_y}, scale_end = {rect.x + rect.width, scale_y};
+  push_line(scale_start, scale_end, 2.f, COLOR_FONT);
+  f32 marker_x = f32_lerp(rect.x, rect.x + rect.width, 0.5f * (correlation + 1.0f));
+  push_line({marker_x, scale_y - margin.x * 0.5f}, {marker_x, scale_y + margin.x * 0.5f}, 4.f, c);
+  // if (mouse_released_over_field) draw_text_input(r, INPUT_RED_COMPONENT, red_width)
+}
+
+// NOTE(Ryan): A gain slider per user band, lowest at the top
+INTERNAL void
+draw_eq_panel(Rectangle r)
+{
+  push_rect(r, COLOR_BG1, 0.05f, 8);
+
+  f32 row_height = r.height / EQ_USER_BANDS;
+  f32 label_width = r.width * 0.15f;
+  f32 font_size = MIN(g_state->font.baseSize * 1.5f, row_height * 0.6f);
+  for (u32 b = 0; b < EQ_USER_BANDS; b += 1)
   {
-    text = "medium"; c = COLOR_YELLOW_ACCENT;
+    BiquadParams *band = &g_state->eq_settings.stages[EQ_FIRST_USER_STAGE + b];
+    f32 y = r.y + b * row_height;
+
+    String8 label = (band->hz < 1000.0f) ? str8_fmt(g_state->frame_arena, "%.0fHz %+.0fdB", band->hz, band->gain_db) :
+                                           str8_fmt(g_state->frame_arena, "%.0fk %+.0fdB", band->hz / 1000.0f, band->gain_db);
+    push_text((const char *)label.content, g_state->font, font_size, {r.x + 5.0f, y + (row_height - font_size) * 0.5f}, COLOR_FONT);
+
+    Rectangle slider = {r.x + label_width, y, r.width - label_width, row_height};
+    f32 value = (band->gain_db + EQ_MAX_GAIN_DB) / (2.0f * EQ_MAX_GAIN_DB);
+    draw_slider(slider, &value, &g_state->eq_dragging[b]);
+    f32 gain_db = F32_ROUND(value * 2.0f * EQ_MAX_GAIN_DB - EQ_MAX_GAIN_DB);
+    if (!f32_eq(gain_db, band->gain_db))
+    {
+      band->gain_db = gain_db;
+      g_state->eq_dirty = true;
+    }
   }
-  push_text(text, g_state->font, font_size, {rect.x + rect.width + 5.f, rect.y}, c);
-  // if (mouse_released_over_field) draw_text_input(r, INPUT_RED_COMPONENT, red_width)
 }
 
 INTERNAL void
-draw_fft(Rectangle r, f32 *samples, u32 num_samples)
+draw_fft(Rectangle r, f32 *samples, f32 *peaks, u32 num_samples)
 {
   // TODO: volume slider
   push_rect(r, COLOR_BG0);
@@ -943,6 +1157,24 @@ draw_fft(Rectangle r, f32 *samples, u32 num_samples)
     }
   }
 
+  PitchReading pitch = g_state->pitch;
+  if (pitch.hz > 0.f)
+  {
+    f32 font_size = g_state->font.baseSize * 1.2f;
+    String8 text = str8_fmt(g_state->frame_arena, "%s%d  %.1f Hz", pitch_class_name(chroma_class_from_hz(pitch.hz)), 
+                            pitch_octave(pitch.hz), pitch.hz);
+    push_text((const char *)text.content, g_state->font, font_size, {r.x, r.y}, COLOR_FONT);
+  }
+
+  LoudnessMeter *loudness = &g_state->loudness;
+  {
+    f32 font_size = g_state->font.baseSize * 1.2f;
+    String8 text = str8_fmt(g_state->frame_arena, "M %.1f  S %.1f  I %.1f LUFS", 
+                            atomic_f32_load(&loudness->momentary), atomic_f32_load(&loudness->short_term),
+                            atomic_f32_load(&loudness->integrated));
+    push_text((const char *)text.content, g_state->font, font_size, {r.x, r.y + font_size}, COLOR_FONT);
+  }
+
   f32 bin_w = 0.f;
   if (!f32_eq(num_samples, 0.f)) bin_w = (r.width / num_samples);
 
@@ -958,23 +1190,27 @@ draw_fft(Rectangle r, f32 *samples, u32 num_samples)
       bin_h
     };  */
 
-    f32 hue = (f32)i / num_samples;
+    f32 hue = (f32)i / num_samples + g_state->key_hue;
+    hue -= F32_FLOOR(hue);
     Color c = ColorFromHSV(360 * hue, 1.0f, 1.0f);
 
     Vector2 start = {r.x + (i * bin_w), r.y + r.height};
     Vector2 end = {start.x, start.y - bin_h};
     push_line(start, end, thickness, c);
   }
-}
 
-INTERNAL f32
-compute_correlation(f32 duration)
-{
-  f32 in_range = f32_map_to_range(0.f, duration, SQUARE(duration), 0.f, g_state->dataset_sum);
-  return (in_range / g_state->dataset_sum);
+  // NOTE(Ryan): Peak markers all go in as one batch
+  f32 *peak_points = MEM_ARENA_PUSH_ARRAY(g_state->frame_arena, f32, 2 * num_samples);
+  for (u32 i = 0; i < num_samples; i += 1)
+  {
+    peak_points[2 * i] = r.x + (i * bin_w);
+    peak_points[2 * i + 1] = r.y + r.height * (1.0f - peaks[i]);
+  }
+  push_points(peak_points, num_samples, 1.5f, COLOR_FONT);
 }
 
 
+
 EXPORT void 
 code_update(State *state)
 { 
@@ -989,6 +1225,32 @@ code_update(State *state)
 
   if (!state->is_initialised)
   {
+    state->samples_ring.samples = MEM_ARENA_PUSH_ARRAY_ZERO(state->arena, f32, RING_SAMPLES);
+    state->samples_ring.stereo = MEM_ARENA_PUSH_ARRAY_ZERO(state->arena, f32, 2 * STEREO_RING_FRAMES);
+
+    u32 max_bands = dsp_max_bands(SPECTRUM_BIN_GROWTH);
+    spectrum_smoothing_init(state->arena, &state->spectrum_smoothing, max_bands);
+    spectrum_history_init(state->arena, &state->spectrum_history, max_bands);
+
+    state->fft_size = FFT_SIZE_DEFAULT;
+    state->peak_refine = PEAK_REFINE_QUADRATIC;
+
+    SlidingDFTConfig bands = ZERO_STRUCT;
+    sliding_dft_config_log_spaced(&bands, SLIDING_DFT_DEFAULT_LOWEST_HZ, SLIDING_DFT_DEFAULT_HIGHEST_HZ, 
+                                  SLIDING_DFT_DEFAULT_BANDS, SLIDING_DFT_DEFAULT_WINDOW);
+    sliding_dft_request(&state->sliding_dft, &bands);
+    equaliser_config_default(&state->eq_settings);
+    equaliser_request(&state->equaliser, &state->eq_settings);
+    convolver_init(state->arena, &state->convolver);
+    crossfader_init(&state->crossfader);
+    state->ir_left = MEM_ARENA_PUSH_ARRAY_ZERO(state->arena, f32, CONVOLVER_MAX_TAPS);
+    state->ir_right = MEM_ARENA_PUSH_ARRAY_ZERO(state->arena, f32, CONVOLVER_MAX_TAPS);
+    MemArena *dsp_arena = mem_arena_allocate(MB(64), MB(1));
+    dsp_worker_init(dsp_arena, &state->dsp_worker, state->fft_size, SPECTRUM_BIN_GROWTH, audio_device_sample_rate(),
+                    state->samples_ring.samples, RING_SAMPLES, &state->samples_ring.num_written);
+    // NOTE(Ryan): After the worker, as the callback reads its sample rate
+    AttachAudioMixedProcessor(mixer_callback);
+    dsp_worker_start(&state->dsp_worker);
     state->is_initialised = true;
   }
 
@@ -998,6 +1260,58 @@ code_update(State *state)
     else MaximizeWindow();
   }
 
+  if (IsKeyPressed(KEY_W))
+  {
+    state->active_window = (WINDOW)((state->active_window + 1) % WINDOW_COUNT);
+    u32 active_window = state->active_window;
+    atomic_u32_store(&state->dsp_worker.active_window, &active_window);
+  }
+
+  if (IsKeyPressed(KEY_M))
+  {
+    state->spectrum_scale = (SPECTRUM_SCALE)((state->spectrum_scale + 1) % SPECTRUM_SCALE_COUNT);
+    u32 spectrum_scale = state->spectrum_scale;
+    atomic_u32_store(&state->dsp_worker.active_scale, &spectrum_scale);
+  }
+
+  if (IsKeyPressed(KEY_R))
+  {
+    state->peak_refine = (PEAK_REFINE)((state->peak_refine + 1) % PEAK_REFINE_COUNT);
+    u32 peak_refine = state->peak_refine;
+    atomic_u32_store(&state->dsp_worker.active_refine, &peak_refine);
+  }
+
+  if (IsKeyPressed(KEY_E)) state->eq_visible = !state->eq_visible;
+  if (state->eq_dirty && equaliser_request(&state->equaliser, &state->eq_settings)) state->eq_dirty = false;
+
+  if (IsKeyPressed(KEY_V))
+  {
+    state->convolver_on = !state->convolver_on;
+    state->convolver_dirty = true;
+  }
+  if (state->convolver_dirty)
+  {
+    if (state->convolver_on && state->ir_taps == 0)
+    {
+      u32 sample_rate = state->dsp_worker.sample_rate;
+      state->ir_taps = MIN((u32)(REVERB_SECONDS * sample_rate), CONVOLVER_MAX_TAPS);
+      reverb_room_impulse(state->ir_left, state->ir_right, state->ir_taps, sample_rate, 0x7ee);
+    }
+    u32 taps = state->convolver_on ? state->ir_taps : 0;
+    if (convolver_request(&state->convolver, state->ir_left, state->ir_right, taps)) state->convolver_dirty = false;
+  }
+  convolver_build(&state->convolver, CONVOLVER_BUILD_PARTITIONS);
+
+  // NOTE(Ryan): Smaller sizes for latency, larger for resolution. 
+  // The worker builds a new size off this thread, and the old one keeps drawing until it's ready
+  b32 fft_smaller = IsKeyPressed(KEY_MINUS), fft_larger = IsKeyPressed(KEY_EQUAL);
+  if (fft_smaller || fft_larger)
+  {
+    if (fft_smaller && state->fft_size > FFT_SIZE_MIN) state->fft_size >>= 1;
+    if (fft_larger && state->fft_size < FFT_SIZE_MAX) state->fft_size <<= 1;
+    atomic_u32_store(&state->dsp_worker.requested_fft_size, &state->fft_size);
+  }
+
   BeginDrawing();
   ClearBackground(COLOR_BG0);
 
@@ -1017,6 +1331,29 @@ code_update(State *state)
     for (u32 i = 0; i < dropped_files.count; i += 1)
     {
       char *path = dropped_files.paths[i];
+      // NOTE(Ryan): Resampled to the device's rate, as that's what it gets convolved with
+      if (IsKeyDown(KEY_LEFT_SHIFT))
+      {
+        Wave wave = LoadWave(path);
+        if (!IsWaveReady(wave)) WARN("Can't load impulse response %s\n", path);
+        else
+        {
+          WaveFormat(&wave, state->dsp_worker.sample_rate, 32, wave.channels);
+          f32 *samples = LoadWaveSamples(wave);
+          state->ir_taps = MIN(wave.frameCount, CONVOLVER_MAX_TAPS);
+          for (u32 t = 0; t < state->ir_taps; t += 1)
+          {
+            state->ir_left[t] = samples[t * wave.channels];
+            state->ir_right[t] = samples[t * wave.channels + (wave.channels > 1)];
+          }
+          UnloadWaveSamples(samples);
+          UnloadWave(wave);
+          state->convolver_on = true;
+          state->convolver_dirty = true;
+        }
+        continue;
+      }
+
       Music music = LoadMusicStream(path);
       if (!IsMusicReady(music)) WARN("Can't load music file %s\n", path);
       else
@@ -1025,20 +1362,7 @@ code_update(State *state)
         strncpy(m->file_name, GetFileName(path), sizeof(m->file_name));
 
         m->music = music;
-        if (i == 0)
-        {
-          MusicFile *active = DEREF_MUSIC_FILE_HANDLE(state->active_music_handle);
-          if (!ZERO_MUSIC_FILE(active))
-          {
-            StopMusicStream(active->music);
-            DetachAudioStreamProcessor(active->music.stream, music_callback);
-          }
-          state->active_music_handle = TO_HANDLE(m);
-
-          AttachAudioStreamProcessor(m->music.stream, music_callback);
-          SetMusicVolume(m->music, 0.5f);
-          PlayMusicStream(m->music);
-        }
+        if (i == 0) crossfade_to_music(m);
         g_state->num_loaded_music_files += 1;
       }
     }
@@ -1067,6 +1391,26 @@ code_update(State *state)
   }
   UpdateMusicStream(active->music);
 
+  // NOTE(Ryan): Both decks keep decoding until the fade is done. 
+  // Once the audio thread has taken the request up and reached the end of it, the deck faded from is stopped
+  if (state->crossfade_dirty && crossfader_request(&state->crossfader, state->active_deck, state->crossfade_frames))
+  {
+    state->crossfade_dirty = false;
+  }
+  MusicFile *fading = DEREF_MUSIC_FILE_HANDLE(state->fading_music_handle);
+  if (!ZERO_MUSIC_FILE(fading))
+  {
+    UpdateMusicStream(fading->music);
+    b32 fade_done = !state->crossfade_dirty && !atomic_u32_load(&state->crossfader.request_pending) && 
+                    !atomic_u32_load(&state->crossfader.fading);
+    if (fade_done)
+    {
+      StopMusicStream(fading->music);
+      DetachAudioStreamProcessor(fading->music.stream, deck_callback(state->active_deck ^ 1));
+      state->fading_music_handle = ZERO_STRUCT;
+    }
+  }
+
   if (!IsMusicReady(active->music))
   {
     const char *text = "Drag 'n' Drop Music";
@@ -1122,48 +1466,44 @@ code_update(State *state)
   else
   {
     // :fft music
-    for (u32 i = 0, j = state->samples_ring.head;
-         i < NUM_SAMPLES;
-         i += 1, j = (j - 1) % NUM_SAMPLES)
+    // NOTE(Ryan): Analysis happens on the DSP worker; just pick up whatever it has finished
+    SpectrumHistory *history = &state->spectrum_history;
+    SpectrumFrame *published = spectrum_exchange_acquire(&state->dsp_worker.exchange);
+    if (published != NULL) spectrum_history_push(history, published);
+
+    SpectrumFrame *latest = &history->frames[history->latest];
+    SpectrumFrame *previous = &history->frames[history->latest ^ 1];
+    u64 num_written = atomic_u64_load(&state->samples_ring.num_written);
+    f32 frame_t = spectrum_history_t(history, num_written);
+
+    OnsetTrack *onsets = &state->dsp_worker.onsets;
+    state->num_onsets = atomic_u64_load(&onsets->num_onsets);
+    if (state->num_onsets > 0)
     {
-      // we are multiplying by 1Hz, so shifting frequencies.
-      f32 t = (f32)i / (NUM_SAMPLES - 1);
-      state->hann_samples[i] = hann_function(state->samples_ring.samples[j], t);
+      state->last_onset_sample = atomic_u64_load(&onsets->onset_samples[(state->num_onsets - 1) % ONSET_HISTORY]);
     }
-
-    fft(state->hann_samples, 1, state->fft_samples, NUM_SAMPLES);
-
-    f32 max_power = 1.0f;
-    for (u32 i = 0; i < HALF_SAMPLES; i += 1)
+    state->beat_phase = onset_track_beat_phase(onsets, num_written);
+    state->tempo_bpm = latest->tempo_bpm;
+    state->tempo_confidence = latest->tempo_confidence;
+    state->pitch = pitch_load(&state->dsp_worker.pitch);
+    state->key = latest->key;
+    state->key_confidence = latest->key_confidence;
+
+    // NOTE(Ryan): Keys are placed around the circle of fifths, with minor keys sharing their relative major's colour,
+    // so closely related keys get similar colours. Eased the short way round
+    if (state->key_confidence > 0.f)
     {
-      f32 power = F32_LN(f32z_power(state->fft_samples[i]));
-      if (power > max_power)
-        max_power = power;
+      u32 tonic = state->key % CHROMA_BINS;
+      if (state->key >= CHROMA_BINS) tonic = (tonic + 3) % CHROMA_BINS;
+      f32 target_hue = (f32)((tonic * 7) % CHROMA_BINS) / CHROMA_BINS;
+      f32 delta = target_hue - state->key_hue;
+      delta -= F32_ROUND(delta);
+      state->key_hue += delta * (1.0f - f32_fast_exp(-2.0f * dt));
+      state->key_hue -= F32_FLOOR(state->key_hue);
     }
 
-    u32 num_bins = 0;
-    for (f32 f = 1.0f; (u32)f < HALF_SAMPLES; f = F32_CEIL(f * 1.06f))
-    {
-      num_bins += 1;
-    }
-
-    u32 j = 0;
-    for (f32 f = 1.0f; (u32)f < HALF_SAMPLES; f = F32_CEIL(f * 1.06f))
-    {
-      f32 next_f = F32_CEIL(f * 1.06f);
-      f32 bin_power = 0.0f;
-      for (u32 i = (u32)f; i < HALF_SAMPLES && i < (u32)next_f; i += 1)
-      {
-        f32 p = F32_LN(f32z_power(state->fft_samples[i]));
-        if (p > bin_power)
-          bin_power = p;
-      }
-
-      f32 target_t = bin_power / max_power;
-      state->draw_samples[j] += (target_t - state->draw_samples[j]) * 8 * dt;
-
-      j += 1;
-    }
+    SpectrumSmoothing *smoothing = &state->spectrum_smoothing;
+    spectrum_smoothing_update(smoothing, previous, latest, frame_t, dt);
 
     Rectangle render_region = {0.f, 0.f, (f32)rw, (f32)rh};
     f32 color_region_t = 0.7f;
@@ -1175,9 +1515,10 @@ code_update(State *state)
     Rectangle fft_region = cut_rect_right(top_region, scroll_region_t);
 
     draw_scroll_region(scroll_region);
-    draw_fft(fft_region, state->draw_samples, num_bins);
+    draw_fft(fft_region, smoothing->levels, smoothing->peaks, latest->num_bands);
+    if (state->eq_visible) draw_eq_panel(cut_rect_top(fft_region, 0.8f));
 
-    f32 correlation = compute_correlation(GetMusicTimeLength(active->music));
+    f32 correlation = atomic_f32_load(&state->stereo_correlation.correlation);
     draw_correlation_region(correlation_region, correlation);
 
     Rectangle text_r = {correlation_region.x + 50, correlation_region.y + 50, 600, 100};
@@ -35,6 +35,52 @@ mov_all_bytes_asm_repeat(RepetitionTester *tester, u32 count)
 
 }
 
+// NOTE(Ryan): A second of stereo audio in 10ms callbacks, so times read as a share of the audio thread
+#define CONVOLVER_BENCH_SAMPLE_RATE 48000
+#define CONVOLVER_BENCH_CALLBACK 480
+// IMPORTANT(Ryan): Processing is in place, so it's run on a fresh copy each time. 
+// Convolving the same buffer over and over would decay it into denormals
+INTERNAL void
+convolver_process_repeat(RepetitionTester *tester, Convolver *conv, f32 *audio, f32 *out)
+{
+  while (update_tester(tester))
+  {
+    MEMORY_COPY(out, audio, 2 * CONVOLVER_BENCH_SAMPLE_RATE * sizeof(f32));
+    TIME_TEST(tester)
+    {
+      for (u32 i = 0; i < CONVOLVER_BENCH_SAMPLE_RATE; i += CONVOLVER_BENCH_CALLBACK)
+      {
+        convolver_process(conv, out + 2 * i, CONVOLVER_BENCH_CALLBACK);
+      }
+      tester_count_bytes(tester, 2 * CONVOLVER_BENCH_SAMPLE_RATE * sizeof(f32));
+    }
+  }
+}
+
+// NOTE(Ryan): Same second straight from the definition, as a baseline
+INTERNAL void
+convolve_direct_repeat(RepetitionTester *tester, f32 *ir, u32 taps, f32 *audio, f32 *out)
+{
+  while (update_tester(tester))
+  {
+    TIME_TEST(tester)
+    {
+      for (u32 i = taps; i < CONVOLVER_BENCH_SAMPLE_RATE; i += 1)
+      {
+        f32 left = 0.0f, right = 0.0f;
+        for (u32 t = 0; t < taps; t += 1)
+        {
+          left += ir[t] * audio[2 * (i - t)];
+          right += ir[t] * audio[2 * (i - t) + 1];
+        }
+        out[2 * i] = left;
+        out[2 * i + 1] = right;
+      }
+      tester_count_bytes(tester, 2 * CONVOLVER_BENCH_SAMPLE_RATE * sizeof(f32));
+    }
+  }
+}
+
 INTERNAL void
 repetition_test(void)
 {
@@ -48,12 +94,1413 @@ repetition_test(void)
   mov_all_bytes_asm_repeat(&tester, count);
 }
 
+INTERNAL void
+convolver_repetition_test(void)
+{
+  MemArena *arena = mem_arena_allocate(MB(64), KB(64));
+  Convolver *conv = MEM_ARENA_PUSH_STRUCT_ZERO(arena, Convolver);
+  convolver_init(arena, conv);
+  f32 *ir = MEM_ARENA_PUSH_ARRAY(arena, f32, CONVOLVER_MAX_TAPS);
+  f32 *audio = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * CONVOLVER_BENCH_SAMPLE_RATE);
+  f32 *out = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, 2 * CONVOLVER_BENCH_SAMPLE_RATE);
+  u32 seed = 0xbe4c;
+  for (u32 t = 0; t < CONVOLVER_MAX_TAPS; t += 1) ir[t] = 0.01f * f32_rand_bilateral(&seed);
+  for (u32 i = 0; i < 2 * CONVOLVER_BENCH_SAMPLE_RATE; i += 1) audio[i] = 0.5f * f32_rand_bilateral(&seed);
+
+  for (u32 taps = KB(1); taps <= CONVOLVER_MAX_TAPS; taps <<= 1)
+  {
+    // NOTE(Ryan): Each switch takes effect on the next callback
+    while (!convolver_request(conv, ir, NULL, taps)) convolver_process(conv, audio, 0);
+    convolver_build(conv, CONVOLVER_MAX_PARTITIONS);
+    convolver_process(conv, audio, 0);
+    // NOTE(Ryan): Fill the history so every partition is summed
+    for (u32 b = 0; b <= taps / CONVOLVER_BLOCK; b += 1)
+    {
+      MEMORY_COPY(out, audio, 2 * CONVOLVER_BLOCK * sizeof(f32));
+      convolver_process(conv, out, CONVOLVER_BLOCK);
+    }
+
+    RepetitionTester partitioned = ZERO_STRUCT;
+    printf("\n--- Repetition Test (convolver_process, %u taps, 1s of 48kHz stereo) ---\n", taps);
+    tester_init_new_wave(&partitioned, 2 * CONVOLVER_BENCH_SAMPLE_RATE * sizeof(f32), linux_estimate_cpu_timer_freq(), 3);
+    convolver_process_repeat(&partitioned, conv, audio, out);
+
+    if (taps <= KB(4))
+    {
+      RepetitionTester direct = ZERO_STRUCT;
+      printf("\n--- Repetition Test (convolve_direct, %u taps, 1s of 48kHz stereo) ---\n", taps);
+      tester_init_new_wave(&direct, 2 * CONVOLVER_BENCH_SAMPLE_RATE * sizeof(f32), linux_estimate_cpu_timer_freq(), 3);
+      convolve_direct_repeat(&direct, ir, taps, audio, out);
+    }
+  }
+
+  mem_arena_deallocate(arena);
+}
+
 void
 test_example(void **state)
 {
 
 }
 
+void
+test_fft_matches_dft(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 n = 256;
+  FFTPlan *plan = fft_plan_create(arena, n);
+  f32 *re = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *im = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *dft_re = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *dft_im = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+
+  u32 seed = 0x1234;
+  for (u32 i = 0; i < n; i += 1)
+  {
+    re[i] = f32_rand_bilateral(&seed);
+    im[i] = f32_rand_bilateral(&seed);
+  }
+
+  for (u32 k = 0; k < n; k += 1)
+  {
+    f64 sum_re = 0.0, sum_im = 0.0;
+    for (u32 t = 0; t < n; t += 1)
+    {
+      f64 angle = -F64_TAU * (f64)((k * t) % n) / (f64)n;
+      sum_re += re[t] * F64_COS(angle) - im[t] * F64_SIN(angle);
+      sum_im += re[t] * F64_SIN(angle) + im[t] * F64_COS(angle);
+    }
+    dft_re[k] = (f32)sum_re;
+    dft_im[k] = (f32)sum_im;
+  }
+
+  fft_execute_kernel(plan, re, im, FFT_KERNEL_SCALAR);
+
+  for (u32 k = 0; k < n; k += 1)
+  {
+    assert_float_equal(re[k], dft_re[k], 1e-4f);
+    assert_float_equal(im[k], dft_im[k], 1e-4f);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_fft_kernels_match_scalar(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  for (u32 n = 2; n <= 8192; n <<= 1)
+  {
+    FFTPlan *plan = fft_plan_create(arena, n);
+    f32 *in_re = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+    f32 *in_im = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+    f32 *ref_re = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+    f32 *ref_im = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+    f32 *re = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+    f32 *im = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+
+    u32 seed = 0x5678 + n;
+    for (u32 i = 0; i < n; i += 1)
+    {
+      in_re[i] = f32_rand_bilateral(&seed);
+      in_im[i] = f32_rand_bilateral(&seed);
+    }
+
+    MEMORY_COPY(ref_re, in_re, n * sizeof(f32));
+    MEMORY_COPY(ref_im, in_im, n * sizeof(f32));
+    fft_execute_kernel(plan, ref_re, ref_im, FFT_KERNEL_SCALAR);
+
+    // NOTE(Ryan): Error grows with log2(n) and the magnitude of the bins, which is ~sqrt(n)
+    f32 tolerance = 1e-5f * plan->log2_n * F32_SQRT((f32)n);
+    for (EACH_NONZERO_ENUM(FFT_KERNEL, kernel))
+    {
+      if (!fft_kernel_available(kernel)) continue;
+
+      MEMORY_COPY(re, in_re, n * sizeof(f32));
+      MEMORY_COPY(im, in_im, n * sizeof(f32));
+      fft_execute_kernel(plan, re, im, kernel);
+
+      for (u32 k = 0; k < n; k += 1)
+      {
+        assert_float_equal(re[k], ref_re[k], tolerance);
+        assert_float_equal(im[k], ref_im[k], tolerance);
+      }
+    }
+
+    mem_arena_reset(arena);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_rfft_matches_complex_fft(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 n = 1024;
+  FFTPlan *plan = fft_plan_create(arena, n);
+  RFFTPlan *rplan = rfft_plan_create(arena, n);
+  f32 *real = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *full_re = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, n);
+  f32 *full_im = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, n);
+  f32 *half_re = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 2 + 1);
+  f32 *half_im = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 2 + 1);
+
+  u32 seed = 0x4321;
+  for (u32 i = 0; i < n; i += 1)
+  {
+    real[i] = f32_rand_bilateral(&seed);
+    full_re[i] = real[i];
+  }
+
+  fft_execute(plan, full_re, full_im);
+  rfft_execute(rplan, real, half_re, half_im);
+
+  for (u32 k = 0; k <= n / 2; k += 1)
+  {
+    assert_float_equal(half_re[k], full_re[k], 1e-3f);
+    assert_float_equal(half_im[k], full_im[k], 1e-3f);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_window_apply_ring_unwraps_from_start(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 n = 1024;
+  u32 ring_count = 4 * n;
+  WindowTable *windows = window_table_create(arena, n);
+  f32 *ring = MEM_ARENA_PUSH_ARRAY(arena, f32, ring_count);
+  f32 *out = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+
+  assert_float_equal(windows->coefficients[WINDOW_HANN][0], 0.f, 1e-6f);
+  assert_float_equal(windows->coefficients[WINDOW_HANN][n / 2], 1.f, 1e-6f);
+  assert_float_equal(windows->coherent_gain[WINDOW_HANN], 0.5f, 1e-6f);
+  assert_float_equal(windows->coherent_gain[WINDOW_HAMMING], 0.54f, 1e-6f);
+
+  u32 seed = 0x9abc;
+  for (u32 i = 0; i < ring_count; i += 1) ring[i] = f32_rand_bilateral(&seed);
+
+  // NOTE(Ryan): Starts that are not a multiple of the lane width exercise the scalar tails
+  u32 starts[] = {0, 1, 7, n / 2 + 3, ring_count - n, ring_count - n + 5, ring_count - 1};
+  for (u32 s = 0; s < ARRAY_COUNT(starts); s += 1)
+  {
+    for (u32 w = 0; w < WINDOW_COUNT; w += 1)
+    {
+      f32 *window = windows->coefficients[w];
+      window_apply_ring(out, window, n, ring, ring_count, starts[s]);
+      for (u32 i = 0; i < n; i += 1)
+      {
+        assert_float_equal(out[i], ring[(starts[s] + i) % ring_count] * window[i], 0.f);
+      }
+    }
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_log_bin_map_matches_band_loop(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 n = 4096;
+  LogBinMap *map = log_bin_map_create(arena, n, 1.06f);
+  f32 *re = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *im = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *power = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *band_log_power = MEM_ARENA_PUSH_ARRAY(arena, f32, map->num_bands);
+
+  u32 seed = 0xdef0;
+  for (u32 i = 0; i < n; i += 1)
+  {
+    re[i] = 100.f * f32_rand_bilateral(&seed);
+    im[i] = 100.f * f32_rand_bilateral(&seed);
+  }
+
+  f32 max_log_power = log_bin_map_reduce(map, re, im, power, band_log_power);
+  // NOTE(Ryan): Logs go through the fast approximation
+  f32 tolerance = 2e-5f;
+
+  f32 expected_max = f32_neg_inf();
+  for (u32 i = 0; i < n; i += 1)
+  {
+    expected_max = MAX(expected_max, F32_LN(SQUARE(re[i]) + SQUARE(im[i])));
+  }
+  assert_float_equal(max_log_power, expected_max, tolerance);
+
+  u32 b = 0;
+  for (f32 f = 1.0f; (u32)f < n; f = F32_CEIL(f * 1.06f))
+  {
+    f32 next_f = F32_CEIL(f * 1.06f);
+    f32 expected = f32_neg_inf();
+    for (u32 i = (u32)f; i < n && i < (u32)next_f; i += 1)
+    {
+      expected = MAX(expected, F32_LN(SQUARE(re[i]) + SQUARE(im[i])));
+    }
+    assert_float_equal(band_log_power[b], expected, tolerance);
+    b += 1;
+  }
+  assert_int_equal(b, map->num_bands);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_lane_math_within_documented_error(void **state)
+{
+  f32 x[LANE_WIDTH], result[LANE_WIDTH];
+
+  // NOTE(Ryan): Sweep the mantissa densely across a spread of exponents
+  for (f32 scale = 1e-30f; scale < 1e30f; scale *= 1e5f)
+  {
+    for (u32 i = 0; i < 4096; i += 1)
+    {
+      f32 v = scale * (1.0f + (f32)i / 4096.f);
+      for (u32 l = 0; l < LANE_WIDTH; l += 1) x[l] = v;
+
+      lane_store(result, lane_log2(lane_r32_load(x)));
+      assert_float_equal(result[0], log2f(v), 2e-5f);
+      assert_float_equal(f32_fast_log2(v), log2f(v), 2e-5f);
+
+      lane_store(result, lane_db_from_power(lane_r32_load(x)));
+      assert_float_equal(result[0], 10.f * log10f(v), 8e-5f);
+    }
+  }
+
+  for (f32 v = -100.f; v < 100.f; v += 0.01f)
+  {
+    for (u32 l = 0; l < LANE_WIDTH; l += 1) x[l] = v;
+
+    f32 expected = exp2f(v);
+    lane_store(result, lane_exp2(lane_r32_load(x)));
+    assert_float_equal(result[0] / expected, 1.f, 4e-6f);
+    assert_float_equal(f32_fast_exp2(v) / expected, 1.f, 4e-6f);
+  }
+}
+
+void
+test_stft_runs_once_per_hop(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  u32 size = 1024, hop = 256, ring_count = 4 * size;
+  STFT *stft = stft_create(arena, size, hop, log_bin_map_create(arena, size / 2, 1.06f), NULL);
+  f32 *ring = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, ring_count);
+  u32 num_bands = stft->bin_map->num_bands;
+  f32 *expected_bands = MEM_ARENA_PUSH_ARRAY(arena, f32, num_bands);
+
+  // NOTE(Ryan): Nothing until a full window has arrived
+  assert_false(stft_update(stft, ring, ring_count, size - 1, WINDOW_HANN));
+  assert_true(stft_update(stft, ring, ring_count, size, WINDOW_HANN));
+  assert_int_equal(stft->frame_end, size);
+
+  // NOTE(Ryan): Re-rendering without new audio does no work
+  assert_false(stft_update(stft, ring, ring_count, size, WINDOW_HANN));
+  assert_false(stft_update(stft, ring, ring_count, size + hop - 1, WINDOW_HANN));
+
+  // NOTE(Ryan): Falling behind several hops analyses only the newest completed one
+  u64 num_written = 0;
+  u32 seed = 0x2468;
+  for (; num_written < size + 3 * hop + 17; num_written += 1)
+  {
+    ring[num_written % ring_count] = f32_rand_bilateral(&seed);
+  }
+  assert_true(stft_update(stft, ring, ring_count, num_written, WINDOW_HANN));
+  assert_int_equal(stft->frame_end, size + 3 * hop);
+  assert_int_equal(stft->num_frames, 2);
+
+  f32 *window = stft->windows->coefficients[WINDOW_HANN];
+  f32 *windowed = MEM_ARENA_PUSH_ARRAY(arena, f32, size);
+  f32 *re = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2 + 1);
+  f32 *im = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2 + 1);
+  f32 *power = MEM_ARENA_PUSH_ARRAY(arena, f32, size / 2);
+  for (u32 i = 0; i < size; i += 1)
+  {
+    windowed[i] = ring[(stft->frame_end - size + i) % ring_count] * window[i];
+  }
+  rfft_execute(stft->plan, windowed, re, im);
+  f32 expected_max = log_bin_map_reduce(stft->bin_map, re, im, power, expected_bands);
+
+  assert_float_equal(stft->peak_log_power, expected_max, 0.f);
+  for (u32 b = 0; b < num_bands; b += 1)
+  {
+    assert_float_equal(stft->band_log_power[b], expected_bands[b], 0.f);
+  }
+
+  SpectrumFrame frame = ZERO_STRUCT;
+  spectrum_frame_init(arena, &frame, num_bands);
+  frame.end_sample = stft->frame_end;
+  frame.hop = hop;
+
+  SpectrumHistory history = ZERO_STRUCT;
+  spectrum_history_init(arena, &history, num_bands);
+  spectrum_history_push(&history, &frame);
+  assert_float_equal(spectrum_history_t(&history, frame.end_sample), 1.f, 0.f);
+  spectrum_history_push(&history, &frame);
+  assert_float_equal(spectrum_history_t(&history, frame.end_sample), 0.f, 0.f);
+  assert_float_equal(spectrum_history_t(&history, frame.end_sample + hop / 2), 0.5f, 1e-6f);
+  assert_float_equal(spectrum_history_t(&history, frame.end_sample + 4 * hop), 1.f, 0.f);
+
+  // NOTE(Ryan): A frame from a different FFT size replaces both, rather than interpolating across sizes
+  SpectrumFrame smaller = ZERO_STRUCT;
+  spectrum_frame_init(arena, &smaller, num_bands / 2);
+  smaller.end_sample = frame.end_sample + hop;
+  spectrum_history_push(&history, &smaller);
+  assert_int_equal(history.frames[0].num_bands, num_bands / 2);
+  assert_int_equal(history.frames[1].num_bands, num_bands / 2);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_spectrum_analyser_stitches_layers(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(8), KB(64));
+
+  u32 size = 8192, ring_count = 4 * size;
+  SpectrumAnalyser *analyser = spectrum_analyser_create(arena, size, 1.06f, 
+                                                        SPECTRUM_SCALE_LOG_BANDS, DSP_DEFAULT_SAMPLE_RATE);
+  assert_int_equal(analyser->num_layers, 2);
+  SpectrumLayer *lows = &analyser->layers[0], *highs = &analyser->layers[1];
+  assert_int_equal(highs->stft->size, size / SPECTRUM_SHORT_SIZE_DIVISOR);
+  assert_int_equal(highs->first_band, lows->stft->bin_map->num_bands);
+  assert_int_equal(highs->first_band + highs->stft->bin_map->num_bands, analyser->num_bands);
+
+  SpectrumFrame frame = ZERO_STRUCT;
+  spectrum_frame_init(arena, &frame, analyser->num_bands);
+  f32 *ring = MEM_ARENA_PUSH_ARRAY(arena, f32, ring_count);
+
+  // NOTE(Ryan): A tone centred on a bin of both FFT sizes, high enough to land in the short layer
+  u32 long_bin = 64 * SPECTRUM_SHORT_SIZE_DIVISOR;
+  for (u32 i = 0; i < ring_count; i += 1)
+  {
+    ring[i] = 0.5f * F32_SIN(F32_TAU * (f32)long_bin * (f32)i / (f32)size);
+  }
+
+  LogBinMap *full_map = log_bin_map_create(arena, size / 2, 1.06f);
+  STFT *reference = stft_create(arena, size, size / FFT_HOP_DIVISOR, full_map, NULL);
+
+  u64 num_written = 2 * size;
+  assert_true(spectrum_analyser_update(analyser, ring, ring_count, num_written, WINDOW_HANN, &frame));
+  assert_true(stft_update(reference, ring, ring_count, num_written, WINDOW_HANN));
+  assert_int_equal(frame.hop, highs->stft->hop);
+
+  // NOTE(Ryan): Lows are the long FFT untouched, and the tone's peak reads the same through the short FFT
+  for (u32 b = 0; b < highs->first_band; b += 1)
+  {
+    assert_float_equal(frame.band_log_power[b], reference->band_log_power[b], 0.f);
+  }
+  assert_float_equal(frame.max_log_power, reference->peak_log_power, 0.05f);
+
+  // NOTE(Ryan): Short hop produces frames in between long ones
+  assert_false(spectrum_analyser_update(analyser, ring, ring_count, num_written + highs->stft->hop - 1, 
+                                        WINDOW_HANN, &frame));
+  assert_true(spectrum_analyser_update(analyser, ring, ring_count, num_written + highs->stft->hop, 
+                                       WINDOW_HANN, &frame));
+  assert_int_equal(lows->stft->num_frames, 1);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_filterbank_matches_dense_weights(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  u32 n = 4096, sample_rate = 44100;
+  f32 bin_hz = (sample_rate / 2.0f) / n;
+  f32 *power = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  u32 seed = 0x7a11;
+  for (u32 i = 0; i < n; i += 1)
+  {
+    power[i] = 1.0f + 100.f * f32_rand_unilateral(&seed);
+  }
+
+  for (u32 scale = SPECTRUM_SCALE_MEL; scale < SPECTRUM_SCALE_COUNT; scale += 1)
+  {
+    Filterbank *bank = filterbank_create(arena, (SPECTRUM_SCALE)scale, n, sample_rate);
+    assert_true(bank->num_filters > 0 && bank->num_filters <= dsp_max_bands(1.06f));
+    if (scale == SPECTRUM_SCALE_MEL) assert_int_equal(bank->num_filters, FILTERBANK_MEL_FILTERS);
+
+    f32 *filter_log_power = MEM_ARENA_PUSH_ARRAY(arena, f32, bank->num_filters);
+    filterbank_apply(bank, power, filter_log_power);
+
+    f32 previous_centre = 0.f;
+    for (u32 k = 0; k < bank->num_filters; k += 1)
+    {
+      f32 lower = 0.f, centre = 0.f, upper = 0.f;
+      filterbank_edges((SPECTRUM_SCALE)scale, sample_rate / 2.0f, bank->num_filters, k, &lower, &centre, &upper);
+      assert_true(lower < centre && centre < upper && centre > previous_centre);
+      previous_centre = centre;
+
+      // NOTE(Ryan): Full row of triangle weights over every bin
+      f64 expected = 0.0;
+      for (u32 j = 1; j < n; j += 1)
+      {
+        f32 f = j * bin_hz;
+        f32 w = (f <= centre) ? (f - lower) / (centre - lower) : (upper - f) / (upper - centre);
+        if (w > 0.f) expected += w * power[j];
+      }
+      if (f64_eq(expected, 0.0))
+      {
+        f32 position = centre / bin_hz;
+        u32 below = (u32)position;
+        f32 t = position - below;
+        expected = (1.0f - t) * power[below] + t * power[below + 1];
+      }
+
+      assert_float_equal(filter_log_power[k], F32_LN((f32)expected), 1e-4f);
+    }
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_spectrum_exchange_hands_over_latest(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  SpectrumExchange exchange = ZERO_STRUCT;
+  spectrum_exchange_init(arena, &exchange, 4);
+
+  assert_null(spectrum_exchange_acquire(&exchange));
+
+  // NOTE(Ryan): Reader only sees the newest of several publishes, and only once
+  for (u64 i = 1; i <= 3; i += 1)
+  {
+    spectrum_exchange_back(&exchange)->end_sample = i;
+    spectrum_exchange_publish(&exchange);
+  }
+  SpectrumFrame *frame = spectrum_exchange_acquire(&exchange);
+  assert_non_null(frame);
+  assert_int_equal(frame->end_sample, 3);
+  assert_null(spectrum_exchange_acquire(&exchange));
+
+  // NOTE(Ryan): Writer never hands out the slot the reader holds
+  for (u32 i = 0; i < 8; i += 1)
+  {
+    assert_ptr_not_equal(spectrum_exchange_back(&exchange), frame);
+    spectrum_exchange_publish(&exchange);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_onset_detector_finds_regular_hits(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 num_bands = 64, hop = 512, sample_rate = 44100, beat_frames = 43;
+  OnsetDetector detector = ZERO_STRUCT;
+  onset_detector_init(arena, &detector, num_bands);
+  OnsetTrack track = ZERO_STRUCT;
+  SpectrumFrame frame = ZERO_STRUCT;
+  spectrum_frame_init(arena, &frame, num_bands);
+  frame.num_bands = num_bands;
+  frame.hop = hop;
+
+  u32 seed = 0x0b5e7;
+  u32 num_found = 0;
+  for (u32 i = 0; i < 20 * beat_frames; i += 1)
+  {
+    // NOTE(Ryan): Noisy steady level, with every band jumping up on each hit then decaying
+    u32 since_hit = (i + beat_frames - 5) % beat_frames;
+    f32 hit = 4.0f * F32_POW(0.5f, (f32)since_hit);
+    for (u32 b = 0; b < num_bands; b += 1)
+    {
+      frame.band_log_power[b] = 5.0f + 0.2f * f32_rand_bilateral(&seed) + hit;
+    }
+    frame.end_sample = (u64)(i + 1) * hop;
+
+    u64 onset = 0;
+    if (onset_detector_update(&detector, &frame, sample_rate, &onset))
+    {
+      onset_track_publish(&track, &detector, onset);
+      assert_int_equal(onset % ((u64)beat_frames * hop), 6 * hop);
+      num_found += 1;
+    }
+  }
+
+  assert_int_equal(num_found, 20);
+  assert_int_equal(atomic_u64_load(&track.num_onsets), 20);
+  f32 expected_period = (f32)(beat_frames * hop);
+  assert_float_equal((f32)atomic_u32_load(&track.beat_period), expected_period, 2.0f);
+  u64 on_beat = atomic_u64_load(&track.beat_anchor) + beat_frames * hop;
+  assert_float_equal(onset_track_beat_phase(&track, on_beat), 0.0f, 1e-3f);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_tempo_estimator_finds_bpm(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 sample_rate = 44100, hop = 256;
+  f32 tempos[] = {90.0f, 128.0f, 150.0f};
+  for (u32 t = 0; t < ARRAY_COUNT(tempos); t += 1)
+  {
+    TempoEstimator tempo = ZERO_STRUCT;
+    tempo_estimator_init(arena, &tempo);
+
+    // NOTE(Ryan): Strong onset on each beat, a weaker one on the off-beat, and a little noise
+    f64 beat = 60.0 * sample_rate / tempos[t];
+    u32 seed = 0x7e3b0;
+    for (u64 end = hop; end < 8 * sample_rate; end += hop)
+    {
+      f64 beats_before = (f64)(end - hop) / beat, beats_after = (f64)end / beat;
+      f32 strength = 0.05f * f32_rand_unilateral(&seed);
+      if ((u64)(beats_after) > (u64)(beats_before)) strength += 1.0f;
+      else if ((u64)(beats_after + 0.5) > (u64)(beats_before + 0.5)) strength += 0.4f;
+      tempo_estimator_push(&tempo, end, strength, sample_rate);
+    }
+
+    assert_float_equal(tempo.bpm, tempos[t], 1.5f);
+    assert_true(tempo.confidence >= TEMPO_CONFIDENT);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_chroma_and_key_from_spectrum(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 num_bins = 4096, sample_rate = 44100;
+  f32 bin_hz = (sample_rate / 2.0f) / num_bins;
+  ChromaMap *map = chroma_map_create(arena, num_bins, sample_rate);
+  assert_true(map->num_runs > 0);
+  for (u32 r = 0; r < map->num_runs; r += 1)
+  {
+    assert_true(map->run_start[r] < map->run_end[r]);
+    if (r > 0) assert_int_equal(map->run_start[r], map->run_end[r - 1]);
+  }
+
+  // NOTE(Ryan): C major scale over a few octaves, leaning on the triad
+  f32 *power = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, num_bins);
+  u32 scale[] = {0, 2, 4, 5, 7, 9, 11};
+  f32 weight[] = {3.0f, 1.0f, 2.0f, 1.0f, 2.5f, 1.0f, 1.0f};
+  for (s32 octave = 3; octave <= 6; octave += 1)
+  {
+    for (u32 i = 0; i < ARRAY_COUNT(scale); i += 1)
+    {
+      s32 semitones_from_a4 = (octave - 4) * 12 + (s32)scale[i] - CHROMA_REFERENCE_CLASS;
+      f32 hz = CHROMA_REFERENCE_HZ * F32_POW(2.0f, semitones_from_a4 / 12.0f);
+      power[F32_ROUND_U32(hz / bin_hz)] += weight[i];
+    }
+  }
+
+  f32 chroma[CHROMA_BINS] = ZERO_STRUCT;
+  chroma_map_accumulate(map, power, chroma);
+  f32 total = 0.f;
+  for (u32 c = 0; c < CHROMA_BINS; c += 1) total += chroma[c];
+  assert_float_equal(total, 1.0f, 1e-5f);
+  assert_float_equal(chroma[0], 3.0f / 11.5f, 1e-5f);
+  assert_float_equal(chroma[1], 0.0f, 1e-5f);
+
+  KeyEstimator key = ZERO_STRUCT;
+  for (u32 i = 0; i < 1000; i += 1) key_estimator_update(&key, chroma, 1024, sample_rate);
+  assert_int_equal(key.key, 0);
+  assert_string_equal((char *)key_name(key.key).content, "C major");
+  assert_true(key.confidence > 0.8f);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_pitch_tracker_follows_tones(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  u32 sample_rate = 44100, ring_count = 8 * YIN_WINDOW;
+  f32 *ring = MEM_ARENA_PUSH_ARRAY_ZERO(arena, f32, ring_count);
+  PitchTracker tracker = ZERO_STRUCT;
+  pitch_tracker_init(arena, &tracker);
+
+  // NOTE(Ryan): Harmonically rich tones across the range, fed in uneven blocks
+  f32 tones[] = {82.41f, 196.0f, 440.0f, 1046.5f};
+  u64 num_written = 0;
+  for (u32 t = 0; t < ARRAY_COUNT(tones); t += 1)
+  {
+    for (u32 block = 0; block < 40; block += 1)
+    {
+      u32 count = 97 + 31 * (block % 5);
+      for (u32 i = 0; i < count; i += 1)
+      {
+        f32 phase = (f32)num_written * tones[t] / sample_rate;
+        f32 saw = 2.0f * (phase - F32_FLOOR(phase)) - 1.0f;
+        ring[num_written & (ring_count - 1)] = 0.5f * saw;
+        num_written += 1;
+      }
+      pitch_tracker_update(&tracker, ring, ring_count, num_written, sample_rate);
+    }
+
+    // NOTE(Ryan): Cross-correlation from the transform matches the direct sum
+    pitch_tracker_correlate(&tracker);
+    for (u32 lag = 0; lag <= YIN_WINDOW; lag += 97)
+    {
+      f64 expected = 0.0;
+      for (u32 j = 0; j < YIN_WINDOW; j += 1) expected += tracker.samples[j] * tracker.samples[j + lag];
+      assert_float_equal(tracker.re[lag], expected, 1e-3 * YIN_WINDOW);
+    }
+
+    PitchReading reading = pitch_tracker_estimate(&tracker, sample_rate);
+    assert_float_equal(reading.hz, tones[t], tones[t] * 0.005f);
+    assert_true(reading.clarity > 1.0f - YIN_THRESHOLD);
+  }
+
+  // NOTE(Ryan): Noise has no period
+  u32 seed = 0x417;
+  for (u32 i = 0; i < 4 * YIN_WINDOW; i += 1)
+  {
+    ring[num_written & (ring_count - 1)] = 0.5f * f32_rand_bilateral(&seed);
+    num_written += 1;
+  }
+  assert_true(pitch_tracker_update(&tracker, ring, ring_count, num_written, sample_rate));
+  assert_float_equal(tracker.reading.hz, 0.0f, 0.0f);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_loudness_meter_reads_reference_tone(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  u32 sample_rate = 48000, block = 441;
+  f32 *interleaved = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * sample_rate);
+
+#if LANE4_ENABLED
+  {
+    KWeighting scalar = ZERO_STRUCT, simd = ZERO_STRUCT;
+    k_weighting_init(&scalar, sample_rate);
+    k_weighting_init(&simd, sample_rate);
+    u32 seed = 0x10d;
+    for (u32 i = 0; i < 2 * sample_rate; i += 1) interleaved[i] = f32_rand_bilateral(&seed);
+    f32 expected = k_weighting_process_scalar(&scalar, interleaved, sample_rate);
+    f32 actual = k_weighting_process_sse4(&simd, interleaved, sample_rate);
+    assert_float_equal(actual, expected, expected * 1e-4f);
+    // NOTE(Ryan): The high-pass pole sits near 1, so fused vs. separate rounding drifts the state a little
+    assert_float_equal(simd.y[3], scalar.y[3], 1e-3f);
+  }
+#endif
+
+  // NOTE(Ryan): A 1kHz sine in both channels reads its level in dBFS, as K-weighting is ~0dB there
+  // and the -0.691 offset cancels what's left. So -20dBFS peak in both is -20 LUFS
+  LoudnessMeter *meter = MEM_ARENA_PUSH_STRUCT_ZERO(arena, LoudnessMeter);
+  f32 amplitudes[] = {0.1f, 0.001f};
+  u64 t = 0;
+  for (u32 a = 0; a < ARRAY_COUNT(amplitudes); a += 1)
+  {
+    for (u32 second = 0; second < 5; second += 1)
+    {
+      for (u32 i = 0; i < sample_rate; i += 1, t += 1)
+      {
+        f32 value = amplitudes[a] * F32_SIN(F32_TAU * 1000.0f * (f32)(t % sample_rate) / sample_rate);
+        interleaved[2 * i] = interleaved[2 * i + 1] = value;
+      }
+      for (u32 i = 0; i < sample_rate; i += block)
+      {
+        loudness_meter_process(meter, interleaved + 2 * i, MIN(block, sample_rate - i), sample_rate);
+      }
+    }
+
+    f32 expected = 20.0f * F32_LOG(10.0f, amplitudes[a]);
+    assert_float_equal(atomic_f32_load(&meter->momentary), expected, 0.1f);
+    assert_float_equal(atomic_f32_load(&meter->short_term), expected, 0.1f);
+    // NOTE(Ryan): The quiet half is gated out, rather than pulling the integrated level down to ~-23
+    assert_float_equal(atomic_f32_load(&meter->integrated), -20.0f, 0.1f);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_stereo_correlation_tracks_channel_relationship(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 frames = CORRELATION_CHUNK_FRAMES * CORRELATION_CHUNKS;
+  f32 *interleaved = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * frames);
+  u32 seed = 0xc0de;
+
+  // NOTE(Ryan): Odd lengths exercise the scalar tail alongside the lanes
+  for (u32 i = 0; i < 2 * 333; i += 1) interleaved[i] = f32_rand_bilateral(&seed);
+  f32 lr = 0.f, ll = 0.f, rr = 0.f;
+  stereo_products(interleaved, 333, &lr, &ll, &rr);
+  f64 expected_lr = 0.0, expected_ll = 0.0, expected_rr = 0.0;
+  for (u32 i = 0; i < 333; i += 1)
+  {
+    expected_lr += interleaved[2 * i] * interleaved[2 * i + 1];
+    expected_ll += SQUARE(interleaved[2 * i]);
+    expected_rr += SQUARE(interleaved[2 * i + 1]);
+  }
+  assert_float_equal(lr, expected_lr, 1e-3f);
+  assert_float_equal(ll, expected_ll, 1e-3f);
+  assert_float_equal(rr, expected_rr, 1e-3f);
+
+  // NOTE(Ryan): Mono, one side inverted, then independent noise in each channel
+  f32 right_scales[] = {1.0f, -0.5f, 0.0f};
+  f32 expected[] = {1.0f, -1.0f, 0.0f};
+  StereoCorrelation meter = ZERO_STRUCT;
+  for (u32 t = 0; t < ARRAY_COUNT(right_scales); t += 1)
+  {
+    for (u32 i = 0; i < frames; i += 1)
+    {
+      f32 left = f32_rand_bilateral(&seed);
+      interleaved[2 * i] = left;
+      interleaved[2 * i + 1] = !f32_eq(right_scales[t], 0.0f) ? right_scales[t] * left : f32_rand_bilateral(&seed);
+    }
+    for (u32 i = 0; i < frames; i += 301)
+    {
+      stereo_correlation_process(&meter, interleaved + 2 * i, MIN(301, frames - i));
+    }
+    assert_float_equal(atomic_f32_load(&meter.correlation), expected[t], 0.05f);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_goniometer_points_rotate_mid_side(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  u32 ring_frames = 64, num_frames = 37;
+  f32 *ring = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * ring_frames);
+  u32 seed = 0x9091;
+  for (u32 i = 0; i < 2 * ring_frames; i += 1) ring[i] = f32_rand_bilateral(&seed);
+
+  // NOTE(Ryan): Latest frames straddle the end of the ring
+  u64 num_written = 3 * ring_frames + 10;
+  f32 *unwrapped = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * num_frames + 2);
+  f32 *samples = stereo_ring_unwrap(ring, ring_frames, num_written, num_frames, unwrapped);
+  f32 *xy = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * num_frames);
+  f32 cx = 100.f, cy = 50.f, radius = 40.f;
+  goniometer_points(samples, num_frames, cx, cy, radius, xy);
+
+  for (u32 i = 0; i < num_frames; i += 1)
+  {
+    u32 at = (u32)((num_written - num_frames + i) % ring_frames);
+    f32 left = ring[2 * at], right = ring[2 * at + 1];
+    assert_float_equal(xy[2 * i], cx + 0.5f * radius * (right - left), 1e-4f);
+    assert_float_equal(xy[2 * i + 1], cy - 0.5f * radius * (left + right), 1e-4f);
+  }
+
+  // NOTE(Ryan): Full scale mono is straight up, out of phase horizontal
+  f32 mono[] = {0.f, 1.f, 1.f, -1.f, 1.f, 0.f};
+  goniometer_points(mono + 1, 2, cx, cy, radius, xy);
+  assert_float_equal(xy[0], cx, 1e-4f);
+  assert_float_equal(xy[1], cy - radius, 1e-4f);
+  assert_float_equal(xy[2], cx + radius, 1e-4f);
+  assert_float_equal(xy[3], cy, 1e-4f);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_spectrum_smoothing_ignores_frame_rate(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(1), KB(64));
+
+  // NOTE(Ryan): An odd band count so the scalar tail runs alongside the lanes
+  u32 num_bands = 13;
+  SpectrumFrame frame = ZERO_STRUCT;
+  spectrum_frame_init(arena, &frame, num_bands);
+  frame.max_log_power = 10.0f;
+
+  f32 rates[] = {30.0f, 60.0f, 144.0f};
+  for (u32 r = 0; r < ARRAY_COUNT(rates); r += 1)
+  {
+    SpectrumSmoothing smoothing = ZERO_STRUCT;
+    spectrum_smoothing_init(arena, &smoothing, num_bands);
+    f32 dt = 1.0f / rates[r];
+
+    // NOTE(Ryan): Half a second at 0.8 of full height, then a second of silence
+    for (u32 j = 0; j < num_bands; j += 1) frame.band_log_power[j] = 8.0f;
+    for (u32 step = 0; step < (u32)(0.5f * rates[r]); step += 1)
+    {
+      spectrum_smoothing_update(&smoothing, &frame, &frame, 1.0f, dt);
+    }
+    for (u32 j = 0; j < num_bands; j += 1)
+    {
+      assert_float_equal(smoothing.levels[j], 0.8f, 1e-4f);
+      assert_float_equal(smoothing.peaks[j], 0.8f, 1e-4f);
+    }
+
+    for (u32 j = 0; j < num_bands; j += 1) frame.band_log_power[j] = 0.0f;
+    for (u32 step = 0; step < (u32)rates[r]; step += 1)
+    {
+      spectrum_smoothing_update(&smoothing, &frame, &frame, 1.0f, dt);
+    }
+    f32 expected_level = 0.8f * F32_POW(F32_E, -1.0f / SMOOTHING_RELEASE_SECONDS);
+    f32 expected_peak = 0.8f - PEAK_FALL_PER_SECOND * (1.0f - PEAK_HOLD_SECONDS);
+    for (u32 j = 0; j < num_bands; j += 1)
+    {
+      assert_float_equal(smoothing.levels[j], expected_level, 1e-4f);
+      // NOTE(Ryan): The hold starts once the level stops creeping up to 0.8 and ends on a frame, 
+      // which moves it by a few tens of milliseconds between rates
+      assert_float_equal(smoothing.peaks[j], expected_peak, PEAK_FALL_PER_SECOND * 0.05f);
+    }
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_fft_q15_tracks_float_and_is_bit_exact(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  // NOTE(Ryan): Against the float transform of the same samples, which the Q15 one returns / n
+  u32 sizes[] = {64, 1024};
+  for (u32 s = 0; s < ARRAY_COUNT(sizes); s += 1)
+  {
+    u32 n = sizes[s];
+    FFTPlanQ15 *q15_plan = fft_q15_plan_create(arena, n);
+    FFTPlan *plan = fft_plan_create(arena, n);
+    s16 *q15_re = MEM_ARENA_PUSH_ARRAY(arena, s16, n), *q15_im = MEM_ARENA_PUSH_ARRAY(arena, s16, n);
+    f32 *re = MEM_ARENA_PUSH_ARRAY(arena, f32, n), *im = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+    s32 *log2_power = MEM_ARENA_PUSH_ARRAY(arena, s32, n);
+
+    u32 seed = 0xf13d;
+    for (u32 i = 0; i < n; i += 1)
+    {
+      f32 t = (f32)i / n;
+      q15_re[i] = s16_q15_from_f64(0.5f * F32_SIN(F32_TAU * 10.3f * t) + 0.01f * f32_rand_bilateral(&seed));
+      q15_im[i] = s16_q15_from_f64(0.3f * F32_COS(F32_TAU * 21.7f * t));
+      re[i] = q15_re[i] / 32768.0f;
+      im[i] = q15_im[i] / 32768.0f;
+    }
+    fft_q15_execute(q15_plan, q15_re, q15_im);
+    fft_q15_log2_power(q15_plan, q15_re, q15_im, n, log2_power);
+    fft_execute(plan, re, im);
+
+    for (u32 i = 0; i < n; i += 1)
+    {
+      assert_float_equal(q15_re[i] / 32768.0f, re[i] / n, 4.0f / 32768.0f);
+      assert_float_equal(q15_im[i] / 32768.0f, im[i] / n, 4.0f / 32768.0f);
+
+      // NOTE(Ryan): The log only holds up where the bin is well clear of the rounding
+      f32 power = re[i] * re[i] + im[i] * im[i];
+      if (power > SQUARE(64.0f * n / 32768.0f))
+      {
+        assert_float_equal(log2_power[i] / 65536.0f, F32_LOG(2.0f, power), 0.1f);
+      }
+    }
+  }
+
+  // NOTE(Ryan): Full scale input can rotate past full scale mid-transform, where it must clip, not wrap
+  {
+    u32 n = 8, seed = 0x5a7;
+    FFTPlanQ15 *q15_plan = fft_q15_plan_create(arena, n);
+    FFTPlan *plan = fft_plan_create(arena, n);
+    u32 num_saturated = 0;
+    for (u32 trial = 0; trial < 200; trial += 1)
+    {
+      s16 q15_re[8], q15_im[8];
+      f32 re[8], im[8];
+      for (u32 i = 0; i < n; i += 1)
+      {
+        q15_re[i] = (f32_rand_bilateral(&seed) > 0.f) ? S16_MAX : -S16_MAX;
+        q15_im[i] = (f32_rand_bilateral(&seed) > 0.f) ? S16_MAX : -S16_MAX;
+        re[i] = q15_re[i] / 32768.0f;
+        im[i] = q15_im[i] / 32768.0f;
+      }
+      fft_q15_execute(q15_plan, q15_re, q15_im);
+      fft_execute(plan, re, im);
+      for (u32 i = 0; i < n; i += 1)
+      {
+        num_saturated += (q15_re[i] == S16_MAX || q15_re[i] == S16_MIN || q15_im[i] == S16_MAX || q15_im[i] == S16_MIN);
+        assert_float_equal(q15_re[i] / 32768.0f, CLAMP(-1.0f, re[i] / n, 1.0f), 4.0f / 32768.0f);
+        assert_float_equal(q15_im[i] / 32768.0f, CLAMP(-1.0f, im[i] / n, 1.0f), 4.0f / 32768.0f);
+      }
+    }
+    assert_true(num_saturated > 0);
+  }
+
+  // IMPORTANT(Ryan): Pins the exact output for integer input, so the embedded build must match it bit for bit
+  {
+    u32 n = 64, seed = 0x51ed;
+    FFTPlanQ15 *q15_plan = fft_q15_plan_create(arena, n);
+    s16 q15_re[64], q15_im[64];
+    s32 log2_power[64];
+    for (u32 i = 0; i < n; i += 1)
+    {
+      seed = seed * 1664525u + 1013904223u;
+      q15_re[i] = (s16)(seed >> 16);
+      seed = seed * 1664525u + 1013904223u;
+      q15_im[i] = (s16)(seed >> 16);
+    }
+    fft_q15_execute(q15_plan, q15_re, q15_im);
+    fft_q15_log2_power(q15_plan, q15_re, q15_im, n, log2_power);
+
+    // NOTE(Ryan): FNV-1a
+    u32 spectrum_hash = 2166136261u, log2_hash = 2166136261u;
+    for (u32 i = 0; i < n; i += 1)
+    {
+      spectrum_hash = (spectrum_hash ^ (u16)q15_re[i]) * 16777619u;
+      spectrum_hash = (spectrum_hash ^ (u16)q15_im[i]) * 16777619u;
+      log2_hash = (log2_hash ^ (u32)log2_power[i]) * 16777619u;
+    }
+    assert_int_equal(spectrum_hash, 0xc7516538);
+    assert_int_equal(log2_hash, 0x0e71cbb3);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_peak_refine_matches_longer_fft(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(16), KB(64));
+
+  u32 size = 2048, long_size = SPECTRUM_REFINE_TO_SIZE, ring_count = 4 * long_size;
+  f32 *ring = MEM_ARENA_PUSH_ARRAY(arena, f32, ring_count);
+  f32 bin = 20.3f;
+  for (u32 i = 0; i < ring_count; i += 1)
+  {
+    ring[i] = 0.5f * F32_SIN(F32_TAU * bin * (f32)i / (f32)size);
+  }
+
+  SpectrumAnalyser *reference = spectrum_analyser_create(arena, long_size, 1.06f, 
+                                                         SPECTRUM_SCALE_LOG_BANDS, DSP_DEFAULT_SAMPLE_RATE);
+  SpectrumFrame reference_frame = ZERO_STRUCT;
+  spectrum_frame_init(arena, &reference_frame, reference->num_bands);
+  assert_true(spectrum_analyser_update(reference, ring, ring_count, 2 * long_size, WINDOW_HANN, &reference_frame));
+  u32 reference_band = 0, reference_width = 0;
+  for (u32 b = 0; b < reference->num_bands; b += 1)
+  {
+    if (reference_frame.band_log_power[b] > reference_frame.band_log_power[reference_band]) reference_band = b;
+    reference_width += (reference_frame.band_log_power[b] > reference_frame.max_log_power - 6.0f);
+  }
+
+  // NOTE(Ryan): The short FFT draws on the long one's bands. Refined, the tone is as narrow there as it is 
+  // in the long FFT, where without refinement it smears over every band its lobe touches
+  u32 widths[PEAK_REFINE_COUNT] = ZERO_STRUCT;
+  for (u32 r = 0; r < PEAK_REFINE_COUNT; r += 1)
+  {
+    SpectrumAnalyser *analyser = spectrum_analyser_create(arena, size, 1.06f, 
+                                                          SPECTRUM_SCALE_LOG_BANDS, DSP_DEFAULT_SAMPLE_RATE);
+    assert_int_equal(analyser->num_bands, reference->num_bands);
+    assert_int_equal(analyser->layers[0].stft->refine_factor, long_size / size);
+
+    SpectrumFrame frame = ZERO_STRUCT;
+    spectrum_frame_init(arena, &frame, analyser->num_bands);
+    assert_true(spectrum_analyser_update(analyser, ring, ring_count, 2 * long_size, WINDOW_HANN, &frame, 
+                                         (PEAK_REFINE)r));
+    u32 band = 0;
+    for (u32 b = 0; b < analyser->num_bands; b += 1)
+    {
+      if (frame.band_log_power[b] > frame.band_log_power[band]) band = b;
+      widths[r] += (frame.band_log_power[b] > frame.max_log_power - 6.0f);
+    }
+    if (r != PEAK_REFINE_NONE) assert_int_equal(band, reference_band);
+  }
+  assert_true(widths[PEAK_REFINE_QUADRATIC] <= reference_width + 1);
+  assert_true(widths[PEAK_REFINE_REASSIGN] <= reference_width + 1);
+  assert_true(widths[PEAK_REFINE_NONE] > 2 * reference_width);
+
+  // NOTE(Ryan): Reassignment places a lone tone exactly, where the parabola is a little off for Hann
+  // and well off for flat-top, whose lobe is nothing like a Gaussian
+  STFT *stft = stft_create(arena, size, size / FFT_HOP_DIVISOR, log_bin_map_create(arena, size / 2 * 4, 1.06f), NULL);
+  WINDOW windows[] = {WINDOW_HANN, WINDOW_BLACKMAN_HARRIS, WINDOW_FLAT_TOP};
+  for (u32 w = 0; w < ARRAY_COUNT(windows); w += 1)
+  {
+    stft->next_frame_end = size;
+    assert_true(stft_update(stft, ring, ring_count, size, windows[w], PEAK_REFINE_REASSIGN));
+    f32 height = 0.f, curve = 0.f;
+    u32 i = (u32)bin;
+    assert_float_equal(i + stft_refine_peak(stft, i, PEAK_REFINE_REASSIGN, &height, &curve), bin, 0.005f);
+    assert_true(curve < 0.f);
+  }
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_sliding_dft_tracks_bands_without_drift(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  u32 sample_rate = 48000, block = 441, window = 1024;
+  f32 *interleaved = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * block);
+  SlidingDFT *bank = MEM_ARENA_PUSH_STRUCT_ZERO(arena, SlidingDFT);
+
+  // NOTE(Ryan): Nothing is published until a request is taken up, and only one request is held at a time
+  sliding_dft_process(bank, interleaved, 0, sample_rate);
+  assert_int_equal(atomic_u32_load(&bank->num_bands), 0);
+  SlidingDFTConfig config = ZERO_STRUCT;
+  config.num_bands = 3;
+  config.window = window;
+  config.hz[0] = 1000.0f;
+  config.hz[1] = 3000.0f;
+  config.hz[2] = 30000.0f;
+  assert_true(sliding_dft_request(bank, &config));
+  assert_false(sliding_dft_request(bank, &config));
+
+  // NOTE(Ryan): A tone on a band reads its mean square, and is 60 bins away from the next band's lobe
+  u64 t = 0;
+  f32 amplitude = 0.5f;
+  for (u32 b = 0; b < 20; b += 1)
+  {
+    for (u32 i = 0; i < block; i += 1, t += 1)
+    {
+      f32 value = amplitude * F32_SIN(F32_TAU * 1000.0f * (f32)(t % sample_rate) / sample_rate);
+      interleaved[2 * i] = interleaved[2 * i + 1] = value;
+    }
+    sliding_dft_process(bank, interleaved, block, sample_rate);
+  }
+  assert_int_equal(atomic_u32_load(&bank->num_bands), 3);
+  assert_int_equal(atomic_u64_load(&bank->num_blocks), 20);
+  f32 expected = 0.5f * SQUARE(amplitude);
+  assert_float_equal(atomic_f32_load(&bank->energies[0]), expected, expected * 0.01f);
+  assert_true(atomic_f32_load(&bank->energies[1]) < expected * 1e-6f);
+  assert_float_equal(atomic_f32_load(&bank->energies[2]), 0.0f, 0.0f);
+
+  // NOTE(Ryan): Every resonator decays, even after its coefficients are rounded to f32
+  for (u32 r = 0; r < ARRAY_COUNT(bank->rotate_re); r += 1)
+  {
+    assert_true(SQUARE(bank->rotate_re[r]) + SQUARE(bank->rotate_im[r]) < 1.0f);
+  }
+
+  // NOTE(Ryan): After a couple of minutes of noise the bands still match a direct, 
+  // double precision sum over the last window. Then a window of silence empties them
+  f32 *last = MEM_ARENA_PUSH_ARRAY(arena, f32, window);
+  u32 seed = 0x5d7;
+  for (u32 b = 0; b < 2 * 60 * sample_rate / block; b += 1)
+  {
+    for (u32 i = 0; i < block; i += 1, t += 1)
+    {
+      interleaved[2 * i] = 0.5f * f32_rand_bilateral(&seed);
+      interleaved[2 * i + 1] = 0.5f * f32_rand_bilateral(&seed);
+      last[t % window] = 0.5f * (interleaved[2 * i] + interleaved[2 * i + 1]);
+    }
+    sliding_dft_process(bank, interleaved, block, sample_rate);
+  }
+  f64 taper = F64_POW(SLIDING_DFT_WINDOW_TAPER, 1.0 / window);
+  for (u32 band = 0; band < 2; band += 1)
+  {
+    f64 re = 0.0, im = 0.0, window_sum = 0.0;
+    for (u32 d = 0; d < window; d += 1)
+    {
+      f64 weight = F64_POW(taper, d) * (0.5 - 0.5 * F64_COS(F64_TAU * d / window));
+      f64 phase = F64_TAU * config.hz[band] * d / sample_rate;
+      re += weight * last[(t - 1 - d) % window] * F64_COS(phase);
+      im += weight * last[(t - 1 - d) % window] * F64_SIN(phase);
+      window_sum += weight;
+    }
+    f32 direct = (f32)(2.0 * (SQUARE(re) + SQUARE(im)) / SQUARE(window_sum));
+    assert_float_equal(atomic_f32_load(&bank->energies[band]), direct, direct * 1e-3f);
+  }
+
+  MEMORY_ZERO(interleaved, 2 * block * sizeof(f32));
+  for (u32 i = 0; i < window; i += block)
+  {
+    sliding_dft_process(bank, interleaved, MIN(block, window - i), sample_rate);
+  }
+  assert_true(atomic_f32_load(&bank->energies[0]) < 1e-10f);
+  assert_true(atomic_f32_load(&bank->energies[1]) < 1e-10f);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_equaliser_matches_cascade_and_flushes_denormals(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  u32 sample_rate = 48000, block = 480, latency = EQ_STAGES - 1;
+  u32 num_frames = 16 * block;
+  f32 *input = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * num_frames);
+  f32 *lanes = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * num_frames);
+  f32 *scalar = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * num_frames);
+  Equaliser *eq = MEM_ARENA_PUSH_STRUCT_ZERO(arena, Equaliser);
+  Equaliser *reference = MEM_ARENA_PUSH_STRUCT_ZERO(arena, Equaliser);
+
+  EqualiserConfig config = ZERO_STRUCT;
+  equaliser_config_default(&config);
+  for (u32 b = 0; b < EQ_USER_BANDS; b += 1)
+  {
+    config.stages[EQ_FIRST_USER_STAGE + b].gain_db = (b % 2) ? -9.0f : 6.0f;
+  }
+  assert_true(equaliser_request(eq, &config));
+  assert_false(equaliser_request(eq, &config));
+
+  u32 seed = 0x3e1;
+  for (u32 i = 0; i < 2 * num_frames; i += 1) input[i] = 0.5f * f32_rand_bilateral(&seed);
+  MEMORY_COPY(lanes, input, 2 * num_frames * sizeof(f32));
+  MEMORY_COPY(scalar, input, 2 * num_frames * sizeof(f32));
+
+  // NOTE(Ryan): The vector build agrees with running one lane at a time, up to fused multiply-add rounding 
+  for (u32 i = 0; i < num_frames; i += block)
+  {
+    equaliser_process(eq, lanes + 2 * i, block, sample_rate);
+  }
+  equaliser_configure(reference, &config, sample_rate);
+  equaliser_run_scalar(reference, scalar, num_frames);
+  for (u32 i = 0; i < 2 * num_frames; i += 1)
+  {
+    assert_float_equal(lanes[i], scalar[i], 1e-3f);
+  }
+
+  // NOTE(Ryan): And both are a plain double precision cascade, just late by a frame per stage after the first
+  f64 z1[EQ_STAGES][2] = ZERO_STRUCT, z2[EQ_STAGES][2] = ZERO_STRUCT;
+  f32 coefficients[EQ_STAGES][5] = ZERO_STRUCT;
+  for (u32 s = 0; s < EQ_STAGES; s += 1) biquad_coefficients(&config.stages[s], sample_rate, coefficients[s]);
+  for (u32 i = 0; i + latency < num_frames; i += 1)
+  {
+    for (u32 channel = 0; channel < 2; channel += 1)
+    {
+      f64 x = input[2 * i + channel];
+      for (u32 s = 0; s < EQ_STAGES; s += 1)
+      {
+        f32 *c = coefficients[s];
+        f64 y = c[0] * x + z1[s][channel];
+        z1[s][channel] = c[1] * x + z2[s][channel] - c[3] * y;
+        z2[s][channel] = c[2] * x - c[4] * y;
+        x = y;
+      }
+      assert_float_equal(lanes[2 * (i + latency) + channel], x, 1e-3f);
+    }
+  }
+
+  // NOTE(Ryan): A peak passes its gain at its centre and leaves everything well away from it alone, 
+  // while the rumble filter takes out DC
+  equaliser_config_default(&config);
+  u32 one_k = 5;
+  assert_float_equal(config.stages[EQ_FIRST_USER_STAGE + one_k].hz, 1000.0f, 0.0f);
+  config.stages[EQ_FIRST_USER_STAGE + one_k].gain_db = 6.0f;
+  assert_true(equaliser_request(eq, &config));
+  f32 tone_hz[3] = {1000.0f, 12000.0f, 0.0f};
+  f32 expected_gain[3] = {F32_POW(10.0f, 6.0f / 20.0f), 1.0f, 0.0f};
+  for (u32 tone = 0; tone < ARRAY_COUNT(tone_hz); tone += 1)
+  {
+    f64 in_power = 0.0, out_power = 0.0;
+    for (u32 b = 0; b < 4 * sample_rate / block; b += 1)
+    {
+      for (u32 i = 0; i < block; i += 1)
+      {
+        f32 phase = tone_hz[tone] * (f32)((b * block + i) % sample_rate) / sample_rate;
+        lanes[2 * i] = lanes[2 * i + 1] = (tone_hz[tone] > 0.0f) ? 0.25f * F32_COS(F32_TAU * phase) : 0.25f;
+      }
+      f64 block_in = 0.0, block_out = 0.0;
+      for (u32 i = 0; i < block; i += 1) block_in += SQUARE(lanes[2 * i]);
+      equaliser_process(eq, lanes, block, sample_rate);
+      for (u32 i = 0; i < block; i += 1) block_out += SQUARE(lanes[2 * i + 1]);
+      // NOTE(Ryan): Only the last second, once the 25Hz high pass has settled
+      if (b >= 3 * sample_rate / block)
+      {
+        in_power += block_in;
+        out_power += block_out;
+      }
+    }
+    f32 gain = (f32)F64_SQRT(out_power / in_power);
+    assert_float_equal(gain, expected_gain[tone], 0.02f);
+  }
+
+  // NOTE(Ryan): Ringing down after a burst never leaves denormals in the filter state, 
+  // and the caller's float mode comes back as it was
+  u32 float_mode = float_mode_flush_denormals();
+  float_mode_restore(float_mode);
+  for (u32 b = 0; b < 10 * sample_rate / block; b += 1)
+  {
+    for (u32 i = 0; i < 2 * block; i += 1) lanes[i] = (b == 0) ? f32_rand_bilateral(&seed) : 0.0f;
+    equaliser_process(eq, lanes, block, sample_rate);
+#if defined(__SSE__)
+    for (u32 l = 0; l < EQ_LANES; l += 1)
+    {
+      assert_true(fpclassify(eq->z1[l]) != FP_SUBNORMAL);
+      assert_true(fpclassify(eq->z2[l]) != FP_SUBNORMAL);
+      assert_true(fpclassify(eq->y[l]) != FP_SUBNORMAL);
+    }
+#endif
+  }
+  assert_int_equal(float_mode_flush_denormals(), float_mode);
+  float_mode_restore(float_mode);
+  for (u32 l = 0; l < EQ_LANES; l += 1) assert_float_equal(eq->z1[l], 0.0f, 0.0f);
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_convolver_matches_direct_convolution(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(64), KB(64));
+
+  // NOTE(Ryan): The inverse real transform undoes the forward one
+  u32 n = CONVOLVER_FFT_SIZE;
+  RFFTPlan *plan = rfft_plan_create(arena, n);
+  f32 *x = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *round_trip = MEM_ARENA_PUSH_ARRAY(arena, f32, n);
+  f32 *re = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 2 + 1);
+  f32 *im = MEM_ARENA_PUSH_ARRAY(arena, f32, n / 2 + 1);
+  u32 seed = 0xc0c;
+  for (u32 i = 0; i < n; i += 1) x[i] = f32_rand_bilateral(&seed);
+  rfft_execute(plan, x, re, im);
+  rfft_inverse_execute(plan, re, im, round_trip);
+  for (u32 i = 0; i < n; i += 1) assert_float_equal(round_trip[i], x[i], 1e-5f);
+
+  Convolver *conv = MEM_ARENA_PUSH_STRUCT_ZERO(arena, Convolver);
+  convolver_init(arena, conv);
+
+  // NOTE(Ryan): A few partitions with a part filled last one, different on each side, 
+  // fed in callbacks that don't line up with blocks
+  u32 taps = 5 * CONVOLVER_BLOCK + 123;
+  f32 *ir[2] = {MEM_ARENA_PUSH_ARRAY(arena, f32, taps), MEM_ARENA_PUSH_ARRAY(arena, f32, taps)};
+  for (u32 t = 0; t < taps; t += 1)
+  {
+    ir[0][t] = 0.05f * f32_rand_bilateral(&seed);
+    ir[1][t] = 0.05f * f32_rand_bilateral(&seed);
+  }
+  // NOTE(Ryan): Built a few partitions at a time and only handed over once whole, 
+  // so the audio thread passes straight through until then
+  assert_true(convolver_request(conv, ir[0], ir[1], taps));
+  assert_false(convolver_build(conv, 2));
+  assert_false(convolver_build(conv, 2));
+  assert_int_equal(atomic_u32_load(&conv->request_pending), 0);
+  f32 untouched[2 * 8] = {0.25f, -0.5f};
+  convolver_process(conv, untouched, ARRAY_COUNT(untouched) / 2);
+  assert_float_equal(untouched[0], 0.25f, 0.0f);
+  assert_float_equal(untouched[1], -0.5f, 0.0f);
+  assert_true(convolver_build(conv, 2));
+  assert_false(convolver_request(conv, ir[0], ir[1], taps));
+
+  u32 num_frames = 20000;
+  f32 *input = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * num_frames);
+  f32 *output = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * num_frames);
+  for (u32 i = 0; i < 2 * num_frames; i += 1) input[i] = 0.5f * f32_rand_bilateral(&seed);
+  MEMORY_COPY(output, input, 2 * num_frames * sizeof(f32));
+  u32 callback_frames[4] = {441, 1, 700, 2048};
+  for (u32 i = 0, c = 0; i < num_frames; c += 1)
+  {
+    u32 count = MIN(callback_frames[c % ARRAY_COUNT(callback_frames)], num_frames - i);
+    convolver_process(conv, output + 2 * i, count);
+    i += count;
+  }
+
+  for (u32 i = 0; i < num_frames; i += 1)
+  {
+    for (u32 channel = 0; channel < 2; channel += 1)
+    {
+      f64 direct = 0.0;
+      for (u32 t = 0; t < taps && t + CONVOLVER_BLOCK <= i; t += 1)
+      {
+        direct += ir[channel][t] * input[2 * (i - CONVOLVER_BLOCK - t) + channel];
+      }
+      assert_float_equal(output[2 * i + channel], direct, 1e-4f);
+    }
+  }
+
+  // NOTE(Ryan): A new IR takes over from the next block, with what came before still in the history. 
+  // Turning it off passes straight through
+  f32 half = 0.5f;
+  assert_true(convolver_request(conv, &half, NULL, 1));
+  assert_true(convolver_build(conv, CONVOLVER_BUILD_PARTITIONS));
+  MEMORY_COPY(output, input, 2 * num_frames * sizeof(f32));
+  convolver_process(conv, output, num_frames);
+  for (u32 i = 2 * CONVOLVER_BLOCK; i < num_frames; i += 1)
+  {
+    assert_float_equal(output[2 * i], 0.5f * input[2 * (i - CONVOLVER_BLOCK)], 1e-5f);
+    assert_float_equal(output[2 * i + 1], 0.5f * input[2 * (i - CONVOLVER_BLOCK) + 1], 1e-5f);
+  }
+
+  assert_true(convolver_request(conv, NULL, NULL, 0));
+  assert_true(convolver_build(conv, CONVOLVER_BUILD_PARTITIONS));
+  MEMORY_COPY(output, input, 2 * num_frames * sizeof(f32));
+  convolver_process(conv, output, num_frames);
+  assert_memory_equal(output, input, 2 * num_frames * sizeof(f32));
+
+  mem_arena_deallocate(arena);
+}
+
+void
+test_crossfader_keeps_equal_power(void **state)
+{
+  MemArena *arena = mem_arena_allocate(MB(4), KB(64));
+
+  Crossfader *x = MEM_ARENA_PUSH_STRUCT(arena, Crossfader);
+  crossfader_init(x);
+  u32 block = 441, fade_frames = 48000;
+  f32 *decks[2] = {MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * block), MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * block)};
+  f32 *expected[2] = {MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * block), MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * block)};
+  f32 *out = MEM_ARENA_PUSH_ARRAY(arena, f32, 2 * block);
+
+  // NOTE(Ryan): Nothing staged is nothing delivered
+  assert_int_equal(crossfader_mix(x, out, block), 0);
+  for (u32 i = 0; i < 2 * block; i += 1) assert_float_equal(out[i], 0.0f, 0.0f);
+
+  // NOTE(Ryan): The first track cuts straight in, and its stream is left silent for raylib
+  assert_true(crossfader_request(x, 1, 0));
+  assert_false(crossfader_request(x, 1, 0));
+  u32 seed = 0xfade;
+  for (u32 i = 0; i < 2 * block; i += 1) expected[1][i] = decks[1][i] = f32_rand_bilateral(&seed);
+  crossfader_stage(x, 1, decks[1], block);
+  for (u32 i = 0; i < 2 * block; i += 1) assert_float_equal(decks[1][i], 0.0f, 0.0f);
+  assert_int_equal(crossfader_mix(x, out, block), block);
+  for (u32 i = 0; i < 2 * block; i += 1) assert_float_equal(out[i], expected[1][i], 0.0f);
+  assert_int_equal(atomic_u32_load(&x->fading), 0);
+
+  // NOTE(Ryan): Then each frame is cos and sin of how far through the fade it is, 
+  // with the deck being faded from staged in two parts
+  assert_true(crossfader_request(x, 0, fade_frames));
+  u32 t = 0;
+  for (; t < fade_frames + block; t += block)
+  {
+    for (u32 i = 0; i < 2 * block; i += 1)
+    {
+      expected[0][i] = decks[0][i] = f32_rand_bilateral(&seed);
+      expected[1][i] = decks[1][i] = f32_rand_bilateral(&seed);
+    }
+    crossfader_stage(x, 0, decks[0], block);
+    crossfader_stage(x, 1, decks[1], 100);
+    crossfader_stage(x, 1, decks[1] + 200, block - 100);
+    assert_int_equal(crossfader_mix(x, out, block), block);
+    assert_int_equal(atomic_u32_load(&x->fading), (t + block < fade_frames) ? 1 : 0);
+
+    for (u32 i = 0; i < block; i += 1)
+    {
+      f32 angle = 0.25f * F32_TAU * MIN(1.0f, (f32)(t + i) / fade_frames);
+      for (u32 channel = 0; channel < 2; channel += 1)
+      {
+        f32 mix = F32_SIN(angle) * expected[0][2 * i + channel] + F32_COS(angle) * expected[1][2 * i + channel];
+        assert_float_equal(out[2 * i + channel], mix, 1e-4f);
+      }
+    }
+  }
+
+  // NOTE(Ryan): Picking the deck being faded from part way through turns the fade round without a jump
+  assert_true(crossfader_request(x, 1, fade_frames));
+  for (u32 i = 0; i < 2 * block; i += 1) decks[1][i] = 1.0f;
+  crossfader_stage(x, 1, decks[1], block);
+  crossfader_mix(x, out, block);
+  f32 before = out[2 * block - 1];
+  assert_true(crossfader_request(x, 0, fade_frames));
+  for (u32 i = 0; i < 2 * block; i += 1) decks[1][i] = 1.0f;
+  crossfader_stage(x, 1, decks[1], block);
+  crossfader_mix(x, out, block);
+  assert_float_equal(out[1], before, 1e-3f);
+  assert_true(out[2 * block - 1] < before);
+
+  // NOTE(Ryan): A deck that runs dry part way is padded with silence
+  for (u32 i = 0; i < 2 * block; i += 1) decks[1][i] = 1.0f;
+  crossfader_stage(x, 1, decks[1], 10);
+  assert_int_equal(crossfader_mix(x, out, block), 10);
+  for (u32 i = 20; i < 2 * block; i += 1) assert_float_equal(out[i], 0.0f, 0.0f);
+
+  mem_arena_deallocate(arena);
+}
+
 int 
 main(void)
 {
@@ -77,17 +1524,45 @@ main(void)
   state->frame_arena = mem_arena_allocate(GB(1), MB(64));
   state->assets.arena = mem_arena_allocate(GB(1), MB(64));
 
-  #define REPETITION 1
-  #if REPETITION
-    repetition_test(); 
-    return 0;
-  #else
 	const struct CMUnitTest tests[] = {
     cmocka_unit_test(test_example),
+    cmocka_unit_test(test_fft_matches_dft),
+    cmocka_unit_test(test_fft_kernels_match_scalar),
+    cmocka_unit_test(test_rfft_matches_complex_fft),
+    cmocka_unit_test(test_window_apply_ring_unwraps_from_start),
+    cmocka_unit_test(test_log_bin_map_matches_band_loop),
+    cmocka_unit_test(test_lane_math_within_documented_error),
+    cmocka_unit_test(test_stft_runs_once_per_hop),
+    cmocka_unit_test(test_spectrum_analyser_stitches_layers),
+    cmocka_unit_test(test_spectrum_exchange_hands_over_latest),
+    cmocka_unit_test(test_filterbank_matches_dense_weights),
+    cmocka_unit_test(test_onset_detector_finds_regular_hits),
+    cmocka_unit_test(test_tempo_estimator_finds_bpm),
+    cmocka_unit_test(test_chroma_and_key_from_spectrum),
+    cmocka_unit_test(test_pitch_tracker_follows_tones),
+    cmocka_unit_test(test_loudness_meter_reads_reference_tone),
+    cmocka_unit_test(test_stereo_correlation_tracks_channel_relationship),
+    cmocka_unit_test(test_goniometer_points_rotate_mid_side),
+    cmocka_unit_test(test_spectrum_smoothing_ignores_frame_rate),
+    cmocka_unit_test(test_fft_q15_tracks_float_and_is_bit_exact),
+    cmocka_unit_test(test_peak_refine_matches_longer_fft),
+    cmocka_unit_test(test_sliding_dft_tracks_bands_without_drift),
+    cmocka_unit_test(test_equaliser_matches_cascade_and_flushes_denormals),
+    cmocka_unit_test(test_convolver_matches_direct_convolution),
+    cmocka_unit_test(test_crossfader_keeps_equal_power),
   };
 
   int cmocka_res = cmocka_run_group_tests(tests, NULL, NULL);
 
-  return cmocka_res;
+  // NOTE(Ryan): Benchmarks take minutes, so are only run after the tests when asked for
+  #define REPETITION 0
+  #if REPETITION
+    repetition_test(); 
   #endif
+  #define REPETITION_CONVOLVER 0
+  #if REPETITION_CONVOLVER
+    convolver_repetition_test(); 
+  #endif
+
+  return cmocka_res;
 }
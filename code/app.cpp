@@ -94,10 +94,6 @@ int main(int argc, char *argv[])
 
   state->assets.arena = mem_arena_allocate(GB(1), MB(64));
 
-  //gen_file("assets/pairs.data", MILLION(1));
-  u32 chunk_size = MB(4);
-  state->dataset_sum = async_read_and_sum("assets/pairs.data", chunk_size);
-
   u32 screen_width = 1920;
   u32 screen_height = 1080;
   SetTraceLogLevel(LOG_WARNING); 
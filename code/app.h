@@ -3,8 +3,10 @@
 
 #include "base/base-inc.h"
 #include "app-assets.h"
+#include "app-dsp.h"
 #include <raylib.h>
 #include <raymath.h>
+#include <rlgl.h>
 
 #define V2(x, y) CCOMPOUND(Vector2){(f32)x, (f32)y}
 #if defined(LANG_CPP)
@@ -43,17 +45,24 @@ GLOBAL MusicFile g_zero_music_file;
 #define ZERO_MUSIC_FILE(ptr) \
   (ptr == &g_zero_music_file) 
 #define MAX_MUSIC_FILES 64
-
-// IMPORTANT(Ryan): The number of samples limits number of frequencies we can derive
-// This seems to be a good number for a decent visualisation
-// Also, as displaying logarithmically, we don't actually have this large number
-#define NUM_SAMPLES (1 << 13) 
-STATIC_ASSERT(IS_POW2(NUM_SAMPLES));
-#define HALF_SAMPLES (NUM_SAMPLES >> 1)
+// NOTE(Ryan): Applied after analysis, so meters read the tracks at their own level
+#define MUSIC_VOLUME 0.5f
+
+// IMPORTANT(Ryan): The FFT size limits number of frequencies we can derive, and is chosen at runtime.
+// The ring is sized for the largest, so switching never loses audio
+// NOTE(Ryan): Room for the analysis window plus however far the audio thread gets ahead of it
+#define RING_SAMPLES (FFT_SIZE_MAX << 2)
+// NOTE(Ryan): The spectrum is displayed logarithmically, so a few hundred bands at most
+#define SPECTRUM_BIN_GROWTH 1.06f
+// NOTE(Ryan): Stereo is only kept for the vectorscope, with room for the audio thread to run ahead of it
+#define STEREO_RING_FRAMES (GONIOMETER_POINTS << 1)
 struct SampleRing
 {
-  f32 samples[NUM_SAMPLES];
-  u32 head;
+  f32 *samples;
+  // NOTE(Ryan): Interleaved L and R, on the same clock as samples
+  f32 *stereo;
+  // NOTE(Ryan): Written by the audio thread after the samples, so everything before it is readable
+  atomic_u64 num_written;
 };
 
 typedef enum
@@ -76,6 +85,7 @@ typedef enum
   RE_CIRCLE,
   RE_LINE,
   RE_TEXTURE,
+  RE_POINTS,
 } RENDER_ELEMENT_TYPE;
 
 typedef enum
@@ -84,6 +94,9 @@ typedef enum
   Z_LAYER_TOOLTIP,
 } Z_LAYER;
 
+// NOTE(Ryan): RE_POINTS fades its trail in steps of this many points
+#define POINTS_PER_GROUP 1024
+
 typedef struct RenderElement RenderElement;
 struct RenderElement
 {
@@ -108,6 +121,10 @@ struct RenderElement
 
   Texture texture;
   f32 scale;
+
+  // NOTE(Ryan): Interleaved x, y
+  f32 *points;
+  u32 num_points;
 };
 
 
@@ -172,6 +189,11 @@ INTROSPECT() struct State
 
   MusicFile music_files[MAX_MUSIC_FILES];
   Handle active_music_handle;
+  // NOTE(Ryan): The track being faded out, on the deck other than active_deck
+  Handle fading_music_handle;
+  u32 active_deck;
+  u32 crossfade_frames;
+  b32 crossfade_dirty;
   u32 num_loaded_music_files;
   f32 active_music_slider_value;
   b32 active_music_slider_dragging;
@@ -181,13 +203,46 @@ INTROSPECT() struct State
   f32 scroll_velocity;
 
   SampleRing samples_ring;
-  f32 hann_samples[NUM_SAMPLES];
-  f32z fft_samples[NUM_SAMPLES];
-  f32 draw_samples[HALF_SAMPLES];
+  WINDOW active_window;
+  SPECTRUM_SCALE spectrum_scale;
+  PEAK_REFINE peak_refine;
+  // NOTE(Ryan): What the EQ panel shows. Handed to the audio thread whenever it's free to take it
+  EqualiserConfig eq_settings;
+  b32 eq_dirty;
+  b32 eq_visible;
+  b32 eq_dragging[EQ_USER_BANDS];
+  // NOTE(Ryan): Either the built in room or the last impulse response dropped with shift held
+  f32 *ir_left;
+  f32 *ir_right;
+  u32 ir_taps;
+  b32 convolver_on;
+  b32 convolver_dirty;
+  u32 fft_size;
+  DSPWorker dsp_worker;
+  SpectrumHistory spectrum_history;
+  SpectrumSmoothing spectrum_smoothing;
+  // NOTE(Ryan): Refreshed from the worker every frame. Samples are in the ring's clock, 
+  // so compare against samples_ring.num_written
+  u64 num_onsets;
+  u64 last_onset_sample;
+  f32 beat_phase;
+  f32 tempo_bpm;
+  f32 tempo_confidence;
+  u32 key;
+  f32 key_confidence;
+  // NOTE(Ryan): Offset into the colour wheel, eased towards the key's
+  f32 key_hue;
+  PitchReading pitch;
+  // NOTE(Ryan): Fed from music_callback
+  LoudnessMeter loudness;
+  StereoCorrelation stereo_correlation;
+  SlidingDFT sliding_dft;
+  Equaliser equaliser;
+  Convolver convolver;
+  // NOTE(Ryan): Fed from each deck's stream, and feeds music_callback
+  Crossfader crossfader;
 
   f32 mouse_last_moved_time;
-
-  u32 dataset_sum;
 };
 
 typedef void (*code_preload_t)(State *s);
@@ -14,6 +14,8 @@
 #include "base/base-math.h"
 // IMPORTANT: Uses stdlib malloc
 #include "base/base-memory.h"
+#include "base/base-lane.h"
+#include "base/base-lane-math.h"
 #include "base/base-string.h"
 
 // NOTE(Ryan):
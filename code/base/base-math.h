@@ -43,6 +43,7 @@
 #define F64_COS(x) cos(x) 
 #define F64_TAN(x) tan(x)
 #define F64_LN(x) log(x)
+#define F64_POW(x, y) pow(x, y)
 #define F64_DEG_TO_RAD(v) (F64_PI_DIV_180 * (v))
 #define F64_RAD_TO_DEG(v) (F64_180_DIV_PI * (v))
 #define F64_TURNS_TO_DEG(v) ((v) * 360.0)
@@ -31,14 +31,16 @@ io_thread_routine(void *params)
 
 typedef pthread_t thread_handle;
 typedef void* thread_function(void *params);
+// NOTE(Ryan): Only joinable threads can be waited on with thread_join()
 INTERNAL thread_handle
-start_thread(thread_function func, void *params)
+start_thread(thread_function func, void *params, b32 joinable = false)
 {
   pthread_attr_t thread_attr = ZERO_STRUCT;
   if (pthread_attr_init(&thread_attr) != 0)
     WARN("Failed to init thread attr.");
-  if (pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_DETACHED) != 0)
-    WARN("Failed to set thread to detached state.");
+  int detach_state = joinable ? PTHREAD_CREATE_JOINABLE : PTHREAD_CREATE_DETACHED;
+  if (pthread_attr_setdetachstate(&thread_attr, detach_state) != 0)
+    WARN("Failed to set thread detach state.");
   // NOTE(Ryan): Set to multiple of common page size 4K
   if (pthread_attr_setstacksize(&thread_attr, KB(4) * 128) != 0)
     WARN("Failed to set thread stack size.");
@@ -145,6 +147,43 @@ atomic_u32_load(atomic_u32 *a)
   return ret;
 }
 
+// NOTE(Ryan): Returns the previous value
+INTERNAL u32
+atomic_u32_exchange(atomic_u32 *a, u32 v)
+{
+  return __atomic_exchange_n(a, v, __ATOMIC_SEQ_CST);
+}
+
+typedef u64 volatile atomic_u64;
+INTERNAL void
+atomic_u64_store(atomic_u64 *a, u64 *v)
+{
+  __atomic_store(a, v, __ATOMIC_SEQ_CST);
+}
+
+INTERNAL u64
+atomic_u64_load(atomic_u64 *a)
+{
+  u64 ret = 0;
+  __atomic_load(a, &ret, __ATOMIC_SEQ_CST);
+  return ret;
+}
+
+typedef f32 volatile atomic_f32;
+INTERNAL void
+atomic_f32_store(atomic_f32 *a, f32 *v)
+{
+  __atomic_store(a, v, __ATOMIC_SEQ_CST);
+}
+
+INTERNAL f32
+atomic_f32_load(atomic_f32 *a)
+{
+  f32 ret = 0.f;
+  __atomic_load(a, &ret, __ATOMIC_SEQ_CST);
+  return ret;
+}
+
 typedef pthread_cond_t thread_cv;
 INTERNAL void
 thread_cv_init(thread_cv *cv)